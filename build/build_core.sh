@@ -35,6 +35,7 @@ fi
 function help(){
     echo "$BASENAME  [option]"
     echo "    -a    : equal -ce"
+    echo "    -b    : execute make bench-ut"
     echo "    -c    : clean before build"
     echo "    -C    : clean libgtest.a if with -c"
     echo "    -d    : dry run"
@@ -56,10 +57,12 @@ CLEAN_GTEST=false
 IT=false
 DRY_RUN=false
 CHECK_ENCODING=false
+BENCH_BUILD=false
 
-while getopts ":aCScdxeghij:" flag; do
+while getopts ":abCScdxeghij:" flag; do
     case $flag in 
     a) CLEAN=true; CHECK_ENCODING=true ;;
+    b) BENCH_BUILD=true ;;
     c) CLEAN=true ;; 
     C) CLEAN_GTEST=true ;; 
     d) DRY_RUN=true ;; 
@@ -123,6 +126,7 @@ function ut() {
     cmd_launcher make $PARA ut
     $CLANG_BUILD && cmd_launcher make $PARA clang-ut
     $SAN_BUILD && cmd_launcher make $PARA san-ut
+    $BENCH_BUILD && cmd_launcher make $PARA bench-ut
 
     popd > /dev/null
 }
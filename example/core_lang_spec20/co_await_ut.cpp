@@ -1,10 +1,12 @@
 #include <coroutine>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <sstream>
 
 #include "gtest_wrapper.h"
 
+#include "coro_frame_allocator.h"
 #include "suppress_warning.h"
 
 namespace use_coroutine {
@@ -15,7 +17,8 @@ class Task {  // コルーチンが返す型
 public:
     /// @struct promise_type
     /// @brief コルーチンのライフサイクルを管理する構造体
-    struct promise_type {
+    /// @details CoroFrameAllocationにより、コルーチンフレームはグローバルnewではなく再利用プールから確保される
+    struct promise_type : CoroFrameAllocation {
         /// @brief コルーチンから Task 型のオブジェクトを返す関数
         /// @return Taskオブジェクト
         Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
@@ -110,6 +113,38 @@ TEST(ExpTerm, use_co_await)
     ASSERT_EQ(2, calls);
     // @@@ sample end
 }
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_MISMATCHED_NEW_DELETE;  // g++は引数付きのoperator newと通常のoperator deleteの組み合わせを誤って警告する
+
+/// @brief フレームをmrから確保するコルーチン
+Task gen_coroutine(std::allocator_arg_t, std::pmr::memory_resource*)
+{
+    co_await std::suspend_always{};
+    co_await std::suspend_always{};
+    co_return;
+}
+SUPPRESS_WARN_END;
+
+TEST(ExpTerm, co_await_frame_allocation)
+{
+    char buffer[1024];
+    auto arena = std::pmr::monotonic_buffer_resource{buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+
+    {
+        Task task = gen_coroutine(std::allocator_arg, &arena);  // 確保できなければstd::bad_alloc
+
+        auto calls = 0;
+        while (task.resume()) {
+            ++calls;
+        }
+        ASSERT_EQ(2, calls);
+    }
+
+    char tiny[8];
+    auto small = std::pmr::monotonic_buffer_resource{tiny, sizeof(tiny), std::pmr::null_memory_resource()};
+    ASSERT_THROW(gen_coroutine(std::allocator_arg, &small), std::bad_alloc);
+}
 }  // namespace use_coroutine
 namespace no_use_coroutine {
 // @@@ sample begin 1:0
@@ -1,10 +1,24 @@
+#include <any>
+#include <array>
 #include <coroutine>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest_wrapper.h"
 
+#include "benchmark_gate.h"
+#include "coro_frame_allocator.h"
+#include "measure_performance.h"
+#include "nstd_generator.h"
 #include "suppress_warning.h"
 
 namespace use_coroutine_pipeline {
@@ -27,8 +41,9 @@ public:
 
     /// @struct promise_type
     /// @brief コルーチンのライフサイクルを管理する構造体
-    struct promise_type {
-        T current_value;
+    /// @details CoroFrameAllocationにより、コルーチンフレームはグローバルnewではなく再利用プールから確保される
+    struct promise_type : CoroFrameAllocation {
+        T current_value{};
 
         /// @brief コルーチンから Generator 型のオブジェクトを返す関数
         /// @return Generatorオブジェクト
@@ -146,6 +161,136 @@ TEST(ExpTerm, use_co_yield)
     EXPECT_EQ(index, expected_values.size());
     // @@@ sample end
 }
+
+// 先頭の引数が(std::allocator_arg, std::pmr::memory_resource*)のコルーチンは、フレームをそのメモリリソースから確保する
+// g++は引数付きのoperator newと通常のoperator deleteの組み合わせを誤って警告する
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_MISMATCHED_NEW_DELETE;
+
+Generator<int> filter_even(std::allocator_arg_t, std::pmr::memory_resource*, Generator<int> input)
+{
+    while (input.move_next()) {
+        if (input.current_value() % 2 == 0) {
+            co_yield input.current_value();
+        }
+    }
+}
+
+Generator<int> double_values(std::allocator_arg_t, std::pmr::memory_resource*, Generator<int> input)
+{
+    while (input.move_next()) {
+        co_yield input.current_value() * 2;
+    }
+}
+
+Generator<int> generate_numbers(std::allocator_arg_t, std::pmr::memory_resource*, int start, int end)
+{
+    for (int i = start; i <= end; ++i) {
+        co_yield i;
+    }
+}
+SUPPRESS_WARN_END;
+
+/// @brief 確保回数を数えるメモリリソース
+class counting_resource final : public std::pmr::memory_resource {
+public:
+    size_t allocations{0};
+    size_t deallocations{0};
+
+private:
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(size, alignment);
+    }
+
+    void do_deallocate(void* mem, size_t size, size_t alignment) override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(mem, size, alignment);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+TEST(ExpTerm, co_yield_frame_allocation)
+{
+    auto mr = counting_resource{};
+
+    {
+        auto numbers = double_values(
+            std::allocator_arg, &mr,
+            filter_even(std::allocator_arg, &mr, generate_numbers(std::allocator_arg, &mr, 1, 10)));
+        ASSERT_EQ(3, mr.allocations);  // 3段のパイプラインのフレーム
+
+        auto sum = 0;
+        while (numbers.move_next()) {
+            sum += numbers.current_value();
+        }
+        ASSERT_EQ(60, sum);
+    }
+    ASSERT_EQ(3, mr.deallocations);
+
+    {
+        auto numbers = generate_numbers(1, 10);  // FrameRecyclingResourceから確保される
+        ASSERT_TRUE(numbers.move_next());
+        ASSERT_EQ(1, numbers.current_value());
+    }
+    ASSERT_EQ(3, mr.allocations);
+
+    // max_align_tを超えるアライメントは扱わない
+    ASSERT_THROW(DoNotOptimize(FrameRecyclingResource::ThreadLocal()->allocate(64, 64)), std::bad_alloc);
+
+    {
+        auto value = 0;
+        auto t     = std::thread{[&value] {
+            // numbersはFrameRecyclingResourceより先に生成されるため、スレッド終了時にはその破棄後に解放される
+            thread_local auto numbers = std::optional<Generator<int>>{};
+
+            numbers.emplace(generate_numbers(1, 10));
+            numbers->move_next();
+            value = numbers->current_value();
+        }};
+        t.join();
+
+        ASSERT_EQ(1, value);
+    }
+}
+
+/// @brief 短いパイプラインの生成と消費を1回の操作とし、フレームの確保/解放の速度を計測する
+template <typename F>
+void measure_frames(char const* name, F&& make_pipeline)
+{
+    auto const stats = RecordBenchmark(
+        name, MeasurePerformanceStats(MeasureOptions{.warmup = 1000, .samples = 20, .ops_per_sample = 1000}, [&] {
+            auto numbers = make_pipeline();
+            while (numbers.move_next()) {
+                DoNotOptimize(numbers.current_value());
+            }
+        }));
+
+    std::cout << name << " : " << 3 * 1e9 / stats.median_ns << "frames/sec " << stats << std::endl;
+}
+
+TEST(Benchmark, co_yield_frame_allocation)
+{
+    measure_frames("coroutine_frame/global_new", [] {
+        auto* mr = std::pmr::new_delete_resource();
+        return double_values(std::allocator_arg, mr,
+                             filter_even(std::allocator_arg, mr, generate_numbers(std::allocator_arg, mr, 1, 4)));
+    });
+
+    measure_frames("coroutine_frame/recycling", [] { return double_values(filter_even(generate_numbers(1, 4))); });
+
+    char buffer[4096];
+    auto arena = std::pmr::monotonic_buffer_resource{buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+    measure_frames("coroutine_frame/monotonic_arena", [&arena] {
+        arena.release();  // 前回のパイプラインのフレームは解放済み
+        return double_values(
+            std::allocator_arg, &arena,
+            filter_even(std::allocator_arg, &arena, generate_numbers(std::allocator_arg, &arena, 1, 4)));
+    });
+}
 }  // namespace use_coroutine_pipeline
 
 namespace no_use_coroutine_pipeline {
@@ -254,3 +399,582 @@ TEST(ExpTerm, no_use_co_yield)
     // @@@ sample end
 }
 }  // namespace no_use_coroutine_pipeline
+
+namespace batched_coroutine_pipeline {
+
+using use_coroutine_pipeline::Generator;
+
+/// @brief 要素をまとめたチャンク。指す領域は、次に再開されるまでチャンクを生成したコルーチンのフレームが保持する
+template <typename T>
+using Chunk = std::span<T const>;
+
+/// @brief [start, end]の数値を、最大batch個ずつのチャンクとして生成する
+Generator<Chunk<int>> generate_number_chunks(int start, int end, size_t batch)
+{
+    auto buffer = std::vector<int>(batch);
+
+    for (auto i = start; i <= end;) {
+        auto n = size_t{0};
+        for (; n < batch && i <= end; ++n, ++i) {
+            buffer[n] = i;
+        }
+        co_yield Chunk<int>{buffer.data(), n};
+    }
+}
+
+/// @brief チャンク単位のフィルタ。predを満たす要素のみから成るチャンクを生成する
+/// @details 分岐のない詰め込み(書き込んでから条件に応じて位置を進める)により、ループをベクトル化しやすくする
+template <typename T, typename PRED>
+Generator<Chunk<T>> filter_chunks(Generator<Chunk<T>> input, PRED pred)
+{
+    auto buffer = std::vector<T>{};
+
+    while (input.move_next()) {
+        auto const chunk = input.current_value();
+        buffer.resize(std::max(buffer.size(), chunk.size()));
+
+        auto n = size_t{0};
+        for (auto v : chunk) {
+            buffer[n] = v;
+            n += pred(v) ? 1 : 0;
+        }
+
+        if (n != 0) {
+            co_yield Chunk<T>{buffer.data(), n};
+        }
+    }
+}
+
+/// @brief チャンク単位の変換。各要素にfを適用したチャンクを生成する
+template <typename T, typename F>
+Generator<Chunk<T>> transform_chunks(Generator<Chunk<T>> input, F f)
+{
+    auto buffer = std::vector<T>{};
+
+    while (input.move_next()) {
+        auto const chunk = input.current_value();
+        buffer.resize(std::max(buffer.size(), chunk.size()));
+
+        for (auto i = 0U; i < chunk.size(); ++i) {
+            buffer[i] = f(chunk[i]);
+        }
+
+        co_yield Chunk<T>{buffer.data(), chunk.size()};
+    }
+}
+
+auto is_even = [](int v) noexcept { return v % 2 == 0; };
+auto twice   = [](int v) noexcept { return v * 2; };
+
+TEST(ExpTerm, co_yield_chunks)
+{
+    // use_co_yieldのパイプラインをチャンク単位で処理する。再開/中断は要素毎ではなくチャンク毎になる
+    auto doubled = transform_chunks(filter_chunks(generate_number_chunks(1, 10, 4), is_even), twice);
+
+    auto values = std::vector<int>{};
+    auto chunks = 0;
+    while (doubled.move_next()) {
+        auto const chunk = doubled.current_value();
+        values.insert(values.end(), chunk.begin(), chunk.end());
+        ++chunks;
+    }
+
+    ASSERT_EQ((std::vector<int>{4, 8, 12, 16, 20}), values);
+    ASSERT_EQ(3, chunks);  // [1, 4], [5, 8], [9, 10]
+}
+
+#ifdef __OPTIMIZE__  // 最適化ビルドでのみ、要求通りの要素数で計測する
+constexpr auto pipeline_elements = 100'000'000;
+#else
+constexpr auto pipeline_elements = 1'000'000;
+#endif
+
+/// @brief パイプライン全体を1回の操作として計測し、1要素当たりの時間を表示する
+template <typename F>
+int64_t measure_pipeline(char const* name, F&& run_pipeline)
+{
+    auto sum = int64_t{0};
+
+    auto const stats = RecordBenchmark(
+        name, MeasurePerformanceStats(MeasureOptions{.warmup = 0, .samples = 3, .ops_per_sample = 1}, [&] {
+            sum = run_pipeline();
+        }));
+
+    std::cout << name << " : " << stats.median_ns / pipeline_elements << "ns/element " << stats << std::endl;
+
+    return sum;
+}
+
+TEST(Benchmark, co_yield_chunks)
+{
+    auto const per_element = measure_pipeline("pipeline/per_element", [] {
+        using namespace use_coroutine_pipeline;
+
+        auto doubled = double_values(filter_even(generate_numbers(1, pipeline_elements)));
+        auto sum     = int64_t{0};
+        while (doubled.move_next()) {
+            sum += doubled.current_value();
+        }
+        return sum;
+    });
+
+    auto const chunked = measure_pipeline("pipeline/chunk_1024", [] {
+        auto numbers = generate_number_chunks(1, pipeline_elements, 1024);
+        auto doubled = transform_chunks(filter_chunks(std::move(numbers), is_even), twice);
+        auto sum     = int64_t{0};
+        while (doubled.move_next()) {
+            for (auto v : doubled.current_value()) {
+                sum += v;
+            }
+        }
+        return sum;
+    });
+
+    auto const eager = measure_pipeline("pipeline/eager", [] {
+        using namespace no_use_coroutine_pipeline;
+
+        auto doubled = double_values(filter_even(generate_numbers(1, pipeline_elements)));
+        auto sum     = int64_t{0};
+        while (doubled.move_next()) {
+            sum += doubled.current_value();
+        }
+        return sum;
+    });
+
+    ASSERT_EQ(per_element, chunked);
+    ASSERT_EQ(per_element, eager);
+}
+}  // namespace batched_coroutine_pipeline
+
+namespace yield_by_reference {
+
+/// @brief コピーとムーブの回数を数える
+struct copy_counter_t {
+    static inline int copies{0};
+    static inline int moves{0};
+
+    int value{0};
+
+    explicit copy_counter_t(int v) noexcept : value{v} {}
+    copy_counter_t(copy_counter_t const& other) noexcept : value{other.value} { ++copies; }
+    copy_counter_t(copy_counter_t&& other) noexcept : value{other.value} { ++moves; }
+    copy_counter_t& operator=(copy_counter_t const&) = delete;
+    copy_counter_t& operator=(copy_counter_t&&)      = delete;
+
+    static void reset() noexcept { copies = moves = 0; }
+};
+
+Nstd::Generator<copy_counter_t> yield_lvalues(int n)
+{
+    auto c = copy_counter_t{0};
+
+    for (; c.value < n; ++c.value) {
+        co_yield c;  // フレーム内の変数への参照を渡す
+    }
+}
+
+Nstd::Generator<copy_counter_t> yield_rvalues(int n)
+{
+    for (auto i = 0; i < n; ++i) {
+        co_yield copy_counter_t{i};  // 一時オブジェクトは再開されるまで生存する
+    }
+}
+
+Nstd::Generator<int> throw_at(int n)
+{
+    for (auto i = 0;; ++i) {
+        if (i == n) {
+            throw std::runtime_error{"throw_at"};
+        }
+        co_yield i;
+    }
+}
+
+TEST(ExpTerm, co_yield_by_reference)
+{
+    {
+        copy_counter_t::reset();
+
+        auto gen     = yield_lvalues(3);
+        auto address = static_cast<copy_counter_t const*>(nullptr);
+        auto sum     = 0;
+
+        while (gen.move_next()) {
+            auto const& c = gen.current_value();
+            if (address != nullptr) {
+                ASSERT_EQ(address, &c);  // 常にフレーム内の同じ変数を指す
+            }
+            address = &c;
+            sum += c.value;
+        }
+
+        ASSERT_EQ(0 + 1 + 2, sum);
+        ASSERT_EQ(0, copy_counter_t::copies);
+        ASSERT_EQ(0, copy_counter_t::moves);
+    }
+    {
+        copy_counter_t::reset();
+
+        auto gen    = yield_rvalues(3);
+        auto values = std::vector<int>{};
+
+        while (gen.move_next()) {
+            values.push_back(gen.take_value().value);  // 右辺値はムーブで取り出す
+        }
+
+        ASSERT_EQ((std::vector<int>{0, 1, 2}), values);
+        ASSERT_EQ(0, copy_counter_t::copies);
+        ASSERT_EQ(3, copy_counter_t::moves);
+    }
+    {
+        copy_counter_t::reset();
+
+        auto gen = yield_lvalues(1);
+
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_EQ(0, gen.take_value().value);  // 左辺値はコピーで取り出す
+        ASSERT_EQ(1, copy_counter_t::copies);
+        ASSERT_FALSE(gen.move_next());
+    }
+    {
+        // 初期化子リストのコンストラクタを持つ型も、要素としてではなくコピーとして取り出す
+        auto gen = []() -> Nstd::Generator<std::vector<std::any>> {
+            auto v = std::vector<std::any>{1, 2, 3};
+            co_yield v;
+        }();
+
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_EQ(3, gen.take_value().size());
+    }
+    {
+        auto gen = throw_at(2);
+
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_THROW(gen.move_next(), std::runtime_error);  // コルーチン内の例外はmove_nextから送出される
+        ASSERT_FALSE(gen.move_next());
+    }
+}
+
+using payload_t = std::array<char, 1024>;
+
+#ifdef __OPTIMIZE__
+constexpr auto payload_count = 1'000'000;
+#else
+constexpr auto payload_count = 10'000;
+#endif
+
+template <template <typename> class GENERATOR>
+GENERATOR<payload_t> generate_payloads(int n)
+{
+    auto payload = payload_t{};
+
+    for (auto i = 0; i < n; ++i) {
+        payload[i % payload.size()] = static_cast<char>(i);
+        co_yield payload;
+    }
+}
+
+template <template <typename> class GENERATOR>
+GENERATOR<std::string> generate_strings(int n)
+{
+    for (auto i = 0; i < n; ++i) {
+        co_yield std::string(1024, static_cast<char>('a' + i % 26));
+    }
+}
+
+template <typename F>
+int64_t measure_payloads(char const* name, F&& consume)
+{
+    auto sum = int64_t{0};
+
+    auto const stats = RecordBenchmark(
+        name, MeasurePerformanceStats(MeasureOptions{.warmup = 1, .samples = 5, .ops_per_sample = 1}, [&] {
+            sum = consume();
+        }));
+
+    std::cout << name << " : " << stats.median_ns / payload_count << "ns/element " << stats << std::endl;
+
+    return sum;
+}
+
+TEST(Benchmark, co_yield_by_reference)
+{
+    auto const array_by_value = measure_payloads("yield_1KiB_array/by_value", [] {
+        auto gen = generate_payloads<use_coroutine_pipeline::Generator>(payload_count);
+        auto sum = int64_t{0};
+        while (gen.move_next()) {
+            sum += gen.current_value()[0];
+        }
+        return sum;
+    });
+
+    auto const array_by_ref = measure_payloads("yield_1KiB_array/by_reference", [] {
+        auto gen = generate_payloads<Nstd::Generator>(payload_count);
+        auto sum = int64_t{0};
+        while (gen.move_next()) {
+            sum += gen.current_value()[0];
+        }
+        return sum;
+    });
+
+    auto const string_by_value = measure_payloads("yield_1KiB_string/by_value", [] {
+        auto gen = generate_strings<use_coroutine_pipeline::Generator>(payload_count);
+        auto sum = int64_t{0};
+        while (gen.move_next()) {
+            auto s = gen.current_value();
+            sum += s.back();
+        }
+        return sum;
+    });
+
+    auto const string_by_move = measure_payloads("yield_1KiB_string/move_out", [] {
+        auto gen = generate_strings<Nstd::Generator>(payload_count);
+        auto sum = int64_t{0};
+        while (gen.move_next()) {
+            auto s = gen.take_value();
+            sum += s.back();
+        }
+        return sum;
+    });
+
+    ASSERT_EQ(array_by_value, array_by_ref);
+    ASSERT_EQ(string_by_value, string_by_move);
+}
+}  // namespace yield_by_reference
+
+namespace generator_ranges {
+
+Nstd::Generator<int> iota(int start)
+{
+    for (auto i = start;; ++i) {
+        co_yield i;
+    }
+}
+
+Nstd::Generator<int> iota(int start, int end)
+{
+    for (auto i = start; i <= end; ++i) {
+        co_yield i;
+    }
+}
+
+static_assert(std::ranges::input_range<Nstd::Generator<int>>);
+static_assert(std::ranges::viewable_range<Nstd::Generator<int>>);
+static_assert(!std::ranges::forward_range<Nstd::Generator<int>>);  // 1回しか走査できない
+
+TEST(ExpTerm, co_yield_ranges)
+{
+    {
+        auto values = std::vector<int>{};
+        for (auto v : iota(1, 5)) {  // 範囲for文
+            values.push_back(v);
+        }
+        ASSERT_EQ((std::vector<int>{1, 2, 3, 4, 5}), values);
+    }
+    {
+        // 無限のGeneratorでも、viewは要求された分だけコルーチンを再開する
+        auto doubled = iota(1) | std::views::filter(batched_coroutine_pipeline::is_even)
+                       | std::views::transform(batched_coroutine_pipeline::twice) | std::views::take(5);
+
+        auto values = std::vector<int>{};
+        for (auto v : doubled) {
+            values.push_back(v);
+        }
+        ASSERT_EQ((std::vector<int>{4, 8, 12, 16, 20}), values);
+    }
+    {
+        auto gen = yield_by_reference::yield_lvalues(3);
+        auto it  = std::ranges::find_if(gen, [](auto const& c) { return c.value == 1; });
+
+        ASSERT_NE(gen.end(), it);
+        ASSERT_EQ(1, (*it).value);
+    }
+    {
+        auto gen = iota(1, 0);  // 空
+
+        ASSERT_EQ(gen.end(), gen.begin());
+    }
+    {
+        ASSERT_EQ(Nstd::Generator<int>::sentinel{}, Nstd::Generator<int>::iterator{});
+    }
+}
+
+TEST(Benchmark, co_yield_ranges)
+{
+    using batched_coroutine_pipeline::pipeline_elements;
+
+    // 3段のコルーチンを要素毎に再開する
+    auto const chained = batched_coroutine_pipeline::measure_pipeline("pipeline/coroutine_chain", [] {
+        using namespace use_coroutine_pipeline;
+
+        auto doubled = double_values(filter_even(generate_numbers(1, pipeline_elements)));
+        auto sum     = int64_t{0};
+        while (doubled.move_next()) {
+            sum += doubled.current_value();
+        }
+        return sum;
+    });
+
+    // コルーチンは1つのみで、filterとtransformは消費側のループに融合される
+    auto const fused = batched_coroutine_pipeline::measure_pipeline("pipeline/ranges_views", [] {
+        auto doubled = iota(1, pipeline_elements) | std::views::filter(batched_coroutine_pipeline::is_even)
+                       | std::views::transform(batched_coroutine_pipeline::twice);
+        auto sum     = int64_t{0};
+        for (auto v : doubled) {
+            sum += v;
+        }
+        return sum;
+    });
+
+    ASSERT_EQ(chained, fused);
+}
+}  // namespace generator_ranges
+
+namespace generator_elements_of {
+
+struct tree_node_t {
+    int                          value;
+    std::unique_ptr<tree_node_t> left;
+    std::unique_ptr<tree_node_t> right;
+};
+
+/// @brief 高さdepthの完全二分木を生成する。値は中間順で0からの連番
+std::unique_ptr<tree_node_t> make_tree(int depth, int& next)
+{
+    if (depth == 0) {
+        return nullptr;
+    }
+
+    auto left  = make_tree(depth - 1, next);
+    auto value = next++;
+    auto right = make_tree(depth - 1, next);
+
+    return std::make_unique<tree_node_t>(tree_node_t{value, std::move(left), std::move(right)});
+}
+
+/// @brief 子のGeneratorを走査して値を再度co_yieldする。1要素当たり、木の深さの回数だけコルーチンを再開する
+Nstd::Generator<int> inorder_nested(tree_node_t const* node)
+{
+    if (node == nullptr) {
+        co_return;
+    }
+
+    for (auto v : inorder_nested(node->left.get())) {
+        co_yield v;
+    }
+    co_yield node->value;
+    for (auto v : inorder_nested(node->right.get())) {
+        co_yield v;
+    }
+}
+
+/// @brief 子のGeneratorに委譲する。最も内側のコルーチンのみを再開する
+Nstd::Generator<int> inorder_delegated(tree_node_t const* node)
+{
+    if (node == nullptr) {
+        co_return;
+    }
+
+    co_yield Nstd::ElementsOf{inorder_delegated(node->left.get())};
+    co_yield node->value;
+    co_yield Nstd::ElementsOf{inorder_delegated(node->right.get())};
+}
+
+/// @brief 深さdepthまで委譲を連鎖させ、最も内側で1つの値を生成する
+Nstd::Generator<int> delegate_chain(int depth)
+{
+    if (depth == 0) {
+        co_yield 42;
+    }
+    else {
+        co_yield Nstd::ElementsOf{delegate_chain(depth - 1)};
+    }
+}
+
+Nstd::Generator<int> delegate_throw()
+{
+    co_yield 1;
+    co_yield Nstd::ElementsOf{yield_by_reference::throw_at(1)};  // 0を生成した後に例外
+    co_yield 2;
+}
+
+TEST(ExpTerm, co_yield_elements_of)
+{
+    auto next = 0;
+    auto tree = make_tree(4, next);
+    ASSERT_EQ(15, next);
+
+    auto expected = std::vector<int>{};
+    for (auto v : inorder_nested(tree.get())) {
+        expected.push_back(v);
+    }
+
+    auto actual = std::vector<int>{};
+    for (auto v : inorder_delegated(tree.get())) {
+        actual.push_back(v);
+    }
+
+    ASSERT_EQ((std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14}), expected);
+    ASSERT_EQ(expected, actual);
+
+    {
+        auto gen = delegate_chain(10'000);  // 委譲の連鎖が深くてもスタックは伸びない
+
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_EQ(42, gen.current_value());
+        ASSERT_FALSE(gen.move_next());
+    }
+    {
+        auto gen = delegate_throw();
+
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_EQ(1, gen.current_value());
+        ASSERT_TRUE(gen.move_next());
+        ASSERT_EQ(0, gen.current_value());
+        ASSERT_THROW(gen.move_next(), std::runtime_error);  // 委譲先の例外は委譲元を経由して送出される
+        ASSERT_FALSE(gen.move_next());
+    }
+}
+
+TEST(Benchmark, co_yield_elements_of)
+{
+    // 要素数が木の高さによらず一定に近くなるよう、木を繰り返し走査する
+#ifdef __OPTIMIZE__
+    constexpr auto elements = 1 << 20;
+#else
+    constexpr auto elements = 1 << 16;
+#endif
+
+    for (auto depth : {4, 8, 12, 16}) {
+        auto       next   = 0;
+        auto const tree   = make_tree(depth, next);
+        auto const repeat = elements / next + 1;
+
+        auto measure = [&](std::string const& name, auto traverse) {
+            auto sum = int64_t{0};
+
+            auto const stats = RecordBenchmark(
+                name, MeasurePerformanceStats(MeasureOptions{.warmup = 0, .samples = 3, .ops_per_sample = 1}, [&] {
+                    sum = 0;
+                    for (auto i = 0; i < repeat; ++i) {
+                        for (auto v : traverse(tree.get())) {
+                            sum += v;
+                        }
+                    }
+                }));
+
+            std::cout << name << " : " << stats.median_ns / (repeat * next) << "ns/element" << std::endl;
+
+            return sum;
+        };
+
+        auto const depth_str = "/depth_" + std::to_string(depth);
+        auto const nested    = measure("tree_inorder/nested" + depth_str, inorder_nested);
+        auto const delegated = measure("tree_inorder/elements_of" + depth_str, inorder_delegated);
+
+        ASSERT_EQ(int64_t{next - 1} * next / 2 * repeat, nested);
+        ASSERT_EQ(nested, delegated);
+    }
+}
+}  // namespace generator_elements_of
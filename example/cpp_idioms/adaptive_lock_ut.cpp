@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "gtest_wrapper.h"
+
+#include "adaptive_lock.h"
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+namespace {
+
+TEST(AdaptiveLock, lock)
+{
+    AdaptiveLock lock{};
+    uint64_t     count{0};
+
+    auto const stats = MeasureContention(ContentionOptions{4, 20'000, false}, [&lock, &count] {
+        std::lock_guard<AdaptiveLock> lg{lock};
+        ++count;
+    });
+
+    ASSERT_EQ(stats.total_ops, count);
+}
+
+TEST(AdaptiveLock, try_lock)
+{
+    AdaptiveLock lock{};
+
+    ASSERT_TRUE(lock.try_lock());
+
+    auto locked = true;
+    std::thread{[&lock, &locked] { locked = lock.try_lock(); }}.join();
+    ASSERT_FALSE(locked);
+
+    lock.unlock();
+    ASSERT_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(AdaptiveLock, park)
+{
+    AdaptiveLock lock{};
+    lock.lock();
+
+    auto acquired = false;
+    std::thread th{[&lock, &acquired] {
+        std::lock_guard<AdaptiveLock> lg{lock};  // スピンで獲得できず、futexで休止する
+        acquired = true;
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    ASSERT_FALSE(acquired);
+
+    lock.unlock();  // 休止しているスレッドを起こす
+    th.join();
+
+    ASSERT_TRUE(acquired);
+}
+
+// BankAccount::transfer_okのmutexをAdaptiveLockにしたもの
+class BankAccount {
+public:
+    explicit BankAccount(int balance) : balance_{balance} {}
+
+    void transfer(BankAccount& to, int amount)
+    {
+        std::scoped_lock lock{lock_, to.lock_};  // try_lockを持つため、複数のロックを安全にロックできる
+
+        if (balance_ >= amount) {
+            balance_ -= amount;
+            to.balance_ += amount;
+        }
+    }
+
+    int balance() const
+    {
+        std::lock_guard<AdaptiveLock> lock{lock_};
+        return balance_;
+    }
+
+private:
+    mutable AdaptiveLock lock_{};
+    int                  balance_;
+};
+
+TEST(AdaptiveLock, scoped_lock)
+{
+    BankAccount acc1{1000};
+    BankAccount acc2{1000};
+
+    std::thread t1{[&acc1, &acc2] {
+        for (auto i = 0; i < 10'000; ++i) {
+            acc1.transfer(acc2, 100);
+        }
+    }};
+
+    std::thread t2{[&acc1, &acc2] {
+        for (auto i = 0; i < 10'000; ++i) {
+            acc2.transfer(acc1, 100);
+        }
+    }};
+
+    t1.join();
+    t2.join();
+
+    ASSERT_EQ(2000, acc1.balance() + acc2.balance());
+}
+
+/// @brief クリティカルセクションがwork_ns程度かかる処理を複数スレッドから実行し、
+///        スループットとプロセスのCPU時間を計測する
+template <typename LOCK>
+void measure_long_critical_section(char const* name, uint32_t threads, std::chrono::nanoseconds work)
+{
+    LOCK     lock{};
+    uint64_t count{0};
+
+    auto const cpu_start = std::clock();
+
+    auto const stats = MeasureContention(ContentionOptions{threads, 200, true}, [&lock, &count, work] {
+        std::lock_guard<LOCK> lg{lock};
+
+        auto const end = std::chrono::steady_clock::now() + work;
+        while (std::chrono::steady_clock::now() < end) {
+            ++count;
+            DoNotOptimize(count);
+        }
+    });
+
+    auto const cpu_ms = (std::clock() - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+
+    std::cout << name << stats << " cpu:" << cpu_ms << "ms" << std::endl;
+}
+
+TEST(Benchmark, adaptive_lock)
+{
+    auto const threads = std::max(4U, HardwareThreads());
+
+    for (auto work : {std::chrono::nanoseconds{100}, std::chrono::nanoseconds{20'000}}) {
+        std::cout << "critical section " << work.count() << "ns" << std::endl;
+        measure_long_critical_section<SpinLock>("  SpinLock     ", threads, work);
+        measure_long_critical_section<AdaptiveLock>("  AdaptiveLock ", threads, work);
+        measure_long_critical_section<std::mutex>("  std::mutex   ", threads, work);
+    }
+}
+}  // namespace
@@ -1,5 +1,6 @@
 #include "gtest_wrapper.h"
 
+#include "allocation_counter.h"
 #include "suppress_warning.h"
 
 namespace {
@@ -160,4 +161,19 @@ TEST(CopyAndSwap, Move)
     ASSERT_EQ("a1", c.GetName1());
 }
 SUPPRESS_WARN_END;
+
+TEST(CopyAndSwap, MoveWithoutAllocation)
+{
+    CopyAndSwap a{"a0", "a1"};
+    CopyAndSwap b{"b0", "b1"};
+
+    auto budget = AllocationBudget{};  // moveはアロケーションを伴わない
+
+    CopyAndSwap c{std::move(a)};
+    b = std::move(c);
+    b.Swap(c);
+
+    ASSERT_FALSE(budget.is_exceeded());
+    ASSERT_STREQ("a0", c.GetName0());
+}
 }  // namespace
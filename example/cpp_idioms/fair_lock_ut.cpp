@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "mcs_lock.h"
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+#include "ticket_lock.h"
+
+namespace {
+
+template <typename LOCK>
+struct Conflict {
+    void increment()
+    {
+        std::lock_guard<LOCK> lock{lock_};
+        ++count_;
+    }
+
+    LOCK     lock_{};
+    uint64_t count_{0};
+};
+
+template <typename LOCK>
+void test_mutual_exclusion()
+{
+    Conflict<LOCK> c{};
+
+    auto const stats = MeasureContention(ContentionOptions{4, 10'000, false}, [&c] { c.increment(); });
+
+    ASSERT_EQ(stats.total_ops, c.count_);
+}
+
+template <typename LOCK>
+void test_try_lock()
+{
+    LOCK lock{};
+
+    ASSERT_TRUE(lock.try_lock());
+
+    auto locked = true;
+    std::thread{[&lock, &locked] { locked = lock.try_lock(); }}.join();
+    ASSERT_FALSE(locked);  // 他スレッドが保持している
+
+    lock.unlock();
+    ASSERT_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(FairLock, ticket_lock)
+{
+    test_mutual_exclusion<TicketLock>();
+    test_try_lock<TicketLock>();
+}
+
+TEST(FairLock, ticket_lock_fifo)
+{
+    TicketLock lock{};
+    lock.lock();
+
+    auto order = std::vector<int>{};
+    auto ths   = std::vector<std::thread>{};
+
+    for (auto i = 0U; i < 4; ++i) {
+        ths.emplace_back([&, i] {
+            std::lock_guard<TicketLock> lg{lock};
+            order.push_back(static_cast<int>(i));
+        });
+
+        while (lock.next_ticket() != i + 2) {  // スレッドiが番号札を取るまで待つ(0はこのスレッドの番号札)
+            std::this_thread::yield();
+        }
+    }
+
+    lock.unlock();
+    for (auto& th : ths) {
+        th.join();
+    }
+
+    ASSERT_EQ((std::vector<int>{0, 1, 2, 3}), order);  // lockを呼び出した順にロックを得る
+}
+
+TEST(FairLock, mcs_lock)
+{
+    test_mutual_exclusion<McsLock>();
+    test_try_lock<McsLock>();
+
+    McsLock a{};  // 同一スレッドが複数のMcsLockを保持し、任意の順で解放できる
+    McsLock b{};
+    {
+        std::scoped_lock lock{a, b};
+    }
+    a.lock();
+    b.lock();
+    a.unlock();
+    b.unlock();
+}
+
+/// @brief 複数スレッドからConflict<LOCK>::incrementを実行し、ロック獲得までの待ち時間の分布を計測する
+template <typename LOCK>
+void measure_acquisition_latency(char const* name, uint32_t threads)
+{
+    constexpr uint32_t ops_per_thread = 10'000;
+
+    Conflict<LOCK> c{};
+
+    auto wait_ns = std::vector<double>(threads * ops_per_thread);
+    auto index   = std::atomic<size_t>{0};
+
+    auto const contention = MeasureContention(ContentionOptions{threads, ops_per_thread, true}, [&] {
+        auto const start = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<LOCK> lock{c.lock_};
+            auto const acquired = std::chrono::steady_clock::now();
+            ++c.count_;
+
+            wait_ns[index.fetch_add(1, std::memory_order_relaxed)]
+                = std::chrono::duration<double, std::nano>{acquired - start}.count();
+        }
+    });
+
+    auto const latency = CalcPerformanceStats(std::move(wait_ns), 1);
+
+    std::cout << name << " threads:" << threads << " ops/sec:" << contention.ops_per_sec
+              << " unfairness:" << contention.unfairness() << " wait median:" << latency.median_ns
+              << "ns p99:" << latency.p99_ns << "ns max:" << latency.samples_ns.back() << "ns" << std::endl;
+
+    ASSERT_EQ(contention.total_ops, c.count_);
+}
+
+TEST(Benchmark, fair_lock)
+{
+    // TicketLockとMcsLockは、ロックを渡す相手がプリエンプトされていると全体が待たされるため、
+    // スレッド数はハードウェアスレッド数までとする
+    for (auto threads = 2U; threads <= std::max(2U, HardwareThreads()); threads *= 2) {
+        measure_acquisition_latency<SpinLock>("SpinLock  ", threads);
+        measure_acquisition_latency<TicketLock>("TicketLock", threads);
+        measure_acquisition_latency<McsLock>("McsLock   ", threads);
+        measure_acquisition_latency<std::mutex>("std::mutex", threads);
+    }
+}
+}  // namespace
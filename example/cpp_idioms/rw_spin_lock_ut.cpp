@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+
+#include "gtest_wrapper.h"
+
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "rw_spin_lock.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+namespace {
+
+TEST(RwSpinLock, shared)
+{
+    RwSpinLock lock{};
+
+    std::shared_lock<RwSpinLock> r0{lock};
+    std::shared_lock<RwSpinLock> r1{lock};  // 共有ロックは同時に獲得できる
+
+    ASSERT_FALSE(lock.try_lock());
+
+    r0.unlock();
+    r1.unlock();
+
+    ASSERT_TRUE(lock.try_lock());
+    ASSERT_FALSE(lock.try_lock_shared());  // 排他ロック中は共有ロックできない
+    lock.unlock();
+}
+
+TEST(RwSpinLock, writer_preference)
+{
+    RwSpinLock lock{};
+    lock.lock_shared();
+
+    auto writer_done = std::atomic<bool>{false};
+    std::thread writer{[&lock, &writer_done] {
+        std::lock_guard<RwSpinLock> lg{lock};
+        writer_done = true;
+    }};
+
+    while (lock.try_lock_shared()) {  // writerがlockを呼び出せば、以後の共有ロックは失敗する
+        lock.unlock_shared();
+        std::this_thread::yield();
+    }
+
+    ASSERT_FALSE(writer_done);
+
+    lock.unlock_shared();
+    writer.join();
+
+    ASSERT_TRUE(writer_done);
+}
+
+/// @brief 型をキーにした読み込みが主体のレジストリ
+template <typename LOCK>
+class TypeRegistry {
+public:
+    void Register(std::type_index type, std::string name)
+    {
+        std::lock_guard<LOCK> lock{lock_};
+        map_[type] = std::move(name);
+    }
+
+    bool Contains(std::type_index type) const
+    {
+        std::shared_lock<LOCK> lock{lock_};  // 読み込みは並行して行える
+        return map_.find(type) != map_.end();
+    }
+
+private:
+    mutable LOCK                                     lock_{};
+    std::unordered_map<std::type_index, std::string> map_{};
+};
+
+/// @brief 共有ロックを持たないロックをTypeRegistryで使用するためのアダプタ
+template <typename LOCK>
+struct ExclusiveOnly : LOCK {
+    void lock_shared() { this->lock(); }
+    void unlock_shared() { this->unlock(); }
+};
+
+TEST(RwSpinLock, type_registry)
+{
+    TypeRegistry<RwSpinLock> registry{};
+
+    registry.Register(typeid(int), "int");
+    registry.Register(typeid(double), "double");
+
+    ASSERT_TRUE(registry.Contains(typeid(int)));
+    ASSERT_FALSE(registry.Contains(typeid(float)));
+
+    auto const stats = MeasureContention(ContentionOptions{4, 10'000, false}, [&registry] {
+        ASSERT_TRUE(registry.Contains(typeid(int)));
+        registry.Register(typeid(double), "double");
+    });
+
+    ASSERT_EQ(40'000, stats.total_ops);
+}
+
+template <typename LOCK>
+void measure_read_write_mix(char const* name, uint32_t write_percent)
+{
+    TypeRegistry<LOCK> registry{};
+    registry.Register(typeid(int), "int");
+
+    auto const threads = std::max(4U, HardwareThreads());
+
+    auto const stats = MeasureContention(ContentionOptions{threads, 20'000, true}, [&] {
+        thread_local auto n = 0U;  // 共有カウンタ自体が競合しないよう、スレッド毎に読み書きを振り分ける
+        if (++n % 100 < write_percent) {
+            registry.Register(typeid(double), "double");
+        }
+        else {
+            DoNotOptimize(registry.Contains(typeid(int)));
+        }
+    });
+
+    std::cout << name << " read/write " << 100 - write_percent << "/" << write_percent << " " << stats << std::endl;
+}
+
+TEST(Benchmark, rw_spin_lock)
+{
+    for (auto write_percent : {5U, 50U}) {
+        measure_read_write_mix<RwSpinLock>("RwSpinLock       ", write_percent);
+        measure_read_write_mix<ExclusiveOnly<SpinLock>>("SpinLock         ", write_percent);
+        measure_read_write_mix<std::shared_mutex>("std::shared_mutex", write_percent);
+    }
+}
+}  // namespace
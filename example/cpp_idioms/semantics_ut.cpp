@@ -1,8 +1,13 @@
+#include <iostream>
 #include <memory>
+#include <string>
 #include <tuple>
 
 #include "gtest_wrapper.h"
 
+#include "allocation_counter.h"
+#include "benchmark_gate.h"
+#include "measure_performance.h"
 #include "suppress_warning.h"
 
 namespace {
@@ -449,4 +454,37 @@ TEST(Semantics, move2)
 
 // @@@ sample end
 
+TEST(Benchmark, move)
+{
+    auto options           = MeasureOptions{};
+    options.warmup         = 100;
+    options.samples        = 20;
+    options.ops_per_sample = 1000;
+
+    auto const name = std::string(1024, 'a');
+
+    auto ineff0      = IneffcientMove{""};
+    auto ineff1      = IneffcientMove{name.c_str()};
+    auto inefficient = RecordBenchmark("move/inefficient", MeasurePerformanceStats(options, [&ineff0, &ineff1] {
+                                           ineff0 = std::move(ineff1);  // 内部ではcopy代入
+                                           ineff1 = std::move(ineff0);
+                                           DoNotOptimize(ineff1);  // 結果を使用しないループとして削除させない
+                                       }));
+
+    auto eff0      = EfficientMove{""};
+    auto eff1      = EfficientMove{name.c_str()};
+    auto efficient = RecordBenchmark("move/efficient", MeasurePerformanceStats(options, [&eff0, &eff1] {
+                                         eff0 = std::move(eff1);  // バッファのmove
+                                         eff1 = std::move(eff0);
+                                         DoNotOptimize(eff1);
+                                     }));
+
+    std::cout << "IneffcientMove : " << inefficient << std::endl;
+    std::cout << "EfficientMove  : " << efficient << std::endl;
+
+    ASSERT_EQ(name, ineff1.Name());
+    ASSERT_EQ(name, eff1.Name());
+    ASSERT_DOUBLE_EQ(0.0, *efficient.allocations_per_op);  // バッファのmoveのみでアロケーションは起こらない
+}
+
 }  // namespace
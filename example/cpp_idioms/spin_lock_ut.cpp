@@ -1,8 +1,13 @@
 #include <atomic>
+#include <iostream>
+#include <mutex>
 #include <thread>
 
 #include "gtest_wrapper.h"
 
+#include "benchmark_gate.h"
+#include "measure_contention.h"
+#include "measure_performance.h"
 #include "spin_lock.h"
 #include "suppress_warning.h"
 
@@ -47,4 +52,97 @@ TEST(Idiom, spin_lock)
     ASSERT_EQ(c.count_, expected);
     // @@@ sample end
 }
+
+TEST(Benchmark, spin_lock)
+{
+    Conflict c{};
+
+    auto options           = MeasureOptions{};
+    options.warmup         = 1000;
+    options.samples        = 20;
+    options.ops_per_sample = 10'000;
+    options.perf_counters  = true;
+
+    auto stats = RecordBenchmark("spin_lock/uncontended", MeasurePerformanceStats(options, [&c] { c.increment(); }));
+
+    std::cout << "SpinLock uncontended lock/unlock : " << stats << std::endl;
+
+    ASSERT_EQ(1000 + 20 * 10'000, c.count_);
+}
+
+TEST(Benchmark, spin_lock_contention)
+{
+    Conflict c{};
+    uint64_t expected = 0;
+
+    for (auto const& stats : SweepContention(100'000, [&c] { c.increment(); })) {
+        std::cout << "SpinLock " << stats << std::endl;
+        expected += stats.total_ops;
+    }
+
+    ASSERT_EQ(c.count_, expected);
+}
+
+TEST(Idiom, spin_lock_try_lock)
+{
+    SpinLock sl{};
+
+    ASSERT_TRUE(sl.try_lock());
+    ASSERT_FALSE(sl.try_lock());  // ロック済み
+
+    sl.unlock();
+    ASSERT_TRUE(sl.try_lock());
+    sl.unlock();
+
+    std::unique_lock<SpinLock> lock{sl, std::try_to_lock};  // Lockable要件を満たす
+    ASSERT_TRUE(lock.owns_lock());
+}
+
+/// @brief 比較用のtest-and-set(exchangeのみでスピンする)スピンロック
+class TasSpinLock {
+public:
+    void lock() noexcept
+    {
+        while (state_.exchange(true, std::memory_order_acquire)) {
+            ;  // busy wait
+        }
+    }
+
+    void unlock() noexcept { state_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> state_{false};
+};
+
+template <typename LOCK>
+struct Counter {
+    void increment()
+    {
+        std::lock_guard<LOCK> lock{lock_};
+        ++count_;
+    }
+
+    LOCK     lock_{};
+    uint64_t count_{0};
+};
+
+TEST(Benchmark, spin_lock_ttas)
+{
+    for (auto threads : {8U, 16U, 32U}) {
+        auto const options = ContentionOptions{threads, 20'000, true};
+
+        Counter<TasSpinLock> tas{};
+        Counter<SpinLock>    ttas{};
+
+        auto const tas_stats  = MeasureContention(options, [&tas] { tas.increment(); });
+        auto const ttas_stats = MeasureContention(options, [&ttas] { ttas.increment(); });
+
+        std::cout << "TAS  " << tas_stats << std::endl;
+        std::cout << "TTAS " << ttas_stats << " speedup:" << ttas_stats.ops_per_sec / tas_stats.ops_per_sec
+                  << std::endl;
+
+        ASSERT_EQ(tas_stats.total_ops, tas.count_);
+        ASSERT_EQ(ttas_stats.total_ops, ttas.count_);
+    }
+}
 }  // namespace
@@ -1,8 +1,26 @@
 #include "gtest_wrapper.h"
 
+#include "allocation_counter.h"
 #include "string_holder_new.h"
 #include "string_holder_old.h"
 
 namespace {
 TEST(Pimpl, string_holder) { StringHolderNew inst; }
+
+TEST(Pimpl, string_holder_allocation)
+{
+    auto budget = AllocationBudget{};
+    {
+        StringHolderNew inst;  // StringHolderNewCoreのためのアロケーション
+        ASSERT_EQ(1, budget.allocations());
+
+        inst.Add("abc");
+
+        auto get_str = AllocationBudget{};  // GetStr()はアロケーションを伴わない
+        ASSERT_STREQ("abc", inst.GetStr());
+        ASSERT_FALSE(get_str.is_exceeded());
+    }
+
+    ASSERT_EQ(budget.allocations(), budget.deallocations());  // リークしていない
+}
 }  // namespace
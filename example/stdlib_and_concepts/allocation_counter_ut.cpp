@@ -0,0 +1,101 @@
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "allocation_counter.h"
+#include "measure_performance.h"
+#include "suppress_warning.h"
+
+namespace {
+TEST(AllocationCounter, count)
+{
+    ASSERT_TRUE(IsAllocationCounterInstalled());
+
+    auto budget = AllocationBudget{};
+
+    int* p = new int{1};
+    DoNotOptimize(p);  // 最適化によるnew/deleteの省略の防止
+
+    ASSERT_EQ(1, budget.allocations());
+    ASSERT_EQ(sizeof(int), budget.bytes());
+    ASSERT_EQ(0, budget.deallocations());
+
+    delete p;
+    ASSERT_EQ(1, budget.deallocations());
+
+    struct alignas(64) CacheLine {
+        char c[64];
+    };
+
+    auto* cl = new CacheLine{};
+    DoNotOptimize(cl);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(cl) % 64);
+    delete cl;
+
+    auto* a = new (std::nothrow) int[4];
+    DoNotOptimize(a);
+    delete[] a;
+
+    ASSERT_EQ(3, budget.allocations());
+    ASSERT_EQ(3, budget.deallocations());
+    ASSERT_TRUE(budget.is_exceeded());
+}
+
+TEST(AllocationCounter, per_thread)
+{
+    auto th_allocations = uint64_t{0};
+
+    std::thread th{[&th_allocations] {
+        auto budget = AllocationBudget{};
+        auto v      = std::vector<int>(100);
+        DoNotOptimize(v);
+
+        th_allocations = budget.allocations();
+    }};
+
+    auto budget = AllocationBudget{};  // std::threadの生成によるアロケーションは含めない
+    th.join();
+
+    ASSERT_EQ(1, th_allocations);
+    ASSERT_EQ(0, budget.allocations());  // 他スレッドのアロケーションはカウントされない
+}
+
+TEST(AllocationCounter, zero_allocation_hot_path)
+{
+    auto v = std::vector<int>{};
+    v.reserve(100);
+
+    auto budget = AllocationBudget{};  // 以下のホットパスはアロケーションしてはならない
+
+    for (auto i = 0; i < 100; ++i) {
+        v.push_back(i);
+    }
+    DoNotOptimize(v);
+
+    ASSERT_FALSE(budget.is_exceeded());
+
+    v.push_back(100);  // reserveした容量を超えたため、再アロケーションが発生する
+    ASSERT_TRUE(budget.is_exceeded());
+}
+
+TEST(AllocationCounter, measure)
+{
+    auto options           = MeasureOptions{};
+    options.warmup         = 10;
+    options.samples        = 10;
+    options.ops_per_sample = 10;
+
+    auto stats = MeasurePerformanceStats(options, [] {
+        auto p = std::make_unique<int>(1);
+        DoNotOptimize(p);
+        return *p;
+    });
+
+    ASSERT_TRUE(stats.allocations_per_op);
+    ASSERT_DOUBLE_EQ(1.0, *stats.allocations_per_op);
+}
+}  // namespace
@@ -0,0 +1,130 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_registry.h"
+#include "scoped_guard.h"
+#include "suppress_warning.h"
+
+namespace {
+TEST(BenchmarkRegistry, record)
+{
+    auto& registry = BenchmarkRegistry::Instance();
+
+    // BENCHMARK_CSV等の出力やベースラインに残らないよう、テスト終了時に削除する
+    auto const erase = Nstd::ScopedGuard{[&registry] { registry.Erase("test/record"); }};
+
+    auto const stats = RecordBenchmark("test/record", CalcPerformanceStats({3.0, 1.0, 2.0}, 1));
+    ASSERT_DOUBLE_EQ(2.0, stats.median_ns);
+
+    auto results = registry.Results();
+    ASSERT_EQ(1, results.count("test/record"));
+    ASSERT_DOUBLE_EQ(2.0, results["test/record"].median_ns);
+}
+
+TEST(BenchmarkRegistry, erase)
+{
+    auto& registry = BenchmarkRegistry::Instance();
+
+    RecordBenchmark("test/erase", CalcPerformanceStats({1.0}, 1));
+    ASSERT_EQ(1, registry.Results().count("test/erase"));
+
+    registry.Erase("test/erase");
+    ASSERT_EQ(0, registry.Results().count("test/erase"));
+}
+
+TEST(BenchmarkRegistry, csv)
+{
+    auto results                   = BenchmarkResults{};
+    results["a"]                   = CalcPerformanceStats({1.5, 2.5}, 10);
+    results["name,with \"quote\""] = CalcPerformanceStats({3.0}, 10);
+
+    auto oss = std::ostringstream{};
+    WriteCsv(oss, results);
+
+    ASSERT_EQ(
+        "name,sample,ns_per_op\n"
+        "a,0,1.5\n"
+        "a,1,2.5\n"
+        "\"name,with \"\"quote\"\"\",0,3\n",
+        oss.str());
+
+    auto iss     = std::istringstream{oss.str()};
+    auto samples = ReadCsv(iss);
+
+    ASSERT_EQ(2, samples.size());
+    ASSERT_EQ((std::vector<double>{1.5, 2.5}), samples["a"]);
+    ASSERT_EQ((std::vector<double>{3.0}), samples["name,with \"quote\""]);
+    ASSERT_EQ(samples, ToSamples(results));
+}
+
+TEST(BenchmarkRegistry, json)
+{
+    auto results = BenchmarkResults{};
+    results["a"] = CalcPerformanceStats({1.0, 3.0}, 10);
+
+    auto oss = std::ostringstream{};
+    WriteJson(oss, results);
+
+    ASSERT_EQ(
+        "{\n  \"benchmarks\": [\n"
+        "    {\"name\": \"a\", \"ops_per_sample\": 10, \"min_ns\": 1, \"median_ns\": 2, \"mean_ns\": 2, "
+        "\"p90_ns\": 2.8, \"p99_ns\": 2.98, \"stddev_ns\": 1.41421, \"samples_ns\": [1, 3]}\n"
+        "  ]\n}\n",
+        oss.str());
+}
+
+TEST(BenchmarkRegistry, mann_whitney)
+{
+    auto const base   = std::vector<double>{10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+    auto const slower = std::vector<double>{20, 21, 22, 23, 24, 25, 26, 27, 28, 29};
+
+    auto const r0 = MannWhitneyU(base, slower);
+    ASSERT_DOUBLE_EQ(100.0, r0.u);  // slowerのすべての値がbaseより大きい
+    ASSERT_LT(r0.p_value, 0.001);
+
+    auto const r1 = MannWhitneyU(slower, base);
+    ASSERT_DOUBLE_EQ(0.0, r1.u);
+    ASSERT_GT(r1.p_value, 0.999);
+
+    auto const r2 = MannWhitneyU(base, base);  // 同じ分布
+    ASSERT_DOUBLE_EQ(50.0, r2.u);
+    ASSERT_GT(r2.p_value, 0.4);
+
+    auto const r3 = MannWhitneyU(std::vector<double>{1, 1, 1}, std::vector<double>{1, 1, 1});  // すべて同順位
+    ASSERT_DOUBLE_EQ(1.0, r3.p_value);
+}
+
+TEST(BenchmarkRegistry, compare_with_baseline)
+{
+    auto baseline    = BenchmarkSamples{};
+    baseline["same"] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+    baseline["slow"] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+    baseline["fast"] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+    baseline["gone"] = {10};
+
+    auto current    = BenchmarkSamples{};
+    current["same"] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+    current["slow"] = {20, 21, 22, 23, 24, 25, 26, 27, 28, 29};
+    current["fast"] = {5, 6, 7, 8, 9, 5, 6, 7, 8, 9};
+    current["new"]  = {10};
+
+    auto const reports = CompareWithBaseline(baseline, current);
+
+    ASSERT_EQ(3, reports.size());  // 両方に存在するものだけを比較する
+
+    ASSERT_EQ("fast", reports[0].name);
+    ASSERT_FALSE(reports[0].is_regression);
+
+    ASSERT_EQ("same", reports[1].name);
+    ASSERT_FALSE(reports[1].is_regression);
+
+    ASSERT_EQ("slow", reports[2].name);
+    ASSERT_TRUE(reports[2].is_regression);
+    ASSERT_DOUBLE_EQ(14.5, reports[2].baseline_median_ns);
+    ASSERT_DOUBLE_EQ(24.5, reports[2].current_median_ns);
+    ASSERT_DOUBLE_EQ(24.5 / 14.5, reports[2].slowdown());
+}
+}  // namespace
@@ -1,5 +1,10 @@
+#include <iostream>
+
 #include "gtest_wrapper.h"
 
+#include "benchmark_gate.h"
+#include "measure_performance.h"
+
 namespace {
 // @@@ sample begin 0:0
 
@@ -40,4 +45,39 @@ TEST(TermExplanation, heap_elision)
     lump();
     emit();
 }
+
+TEST(Benchmark, heap_elision)
+{
+    auto options           = MeasureOptions{};
+    options.warmup         = 100;
+    options.samples        = 20;
+    options.ops_per_sample = 1000;
+
+    // 最適化ビルドではemit()のnew/deleteは省略され得る
+    auto const elided = RecordBenchmark("heap_elision/emit", MeasurePerformanceStats(options, emit));
+
+    // DoNotOptimizeでポインタを外部に見せると、new/deleteは省略できない
+    auto const not_elided = RecordBenchmark("heap_elision/emit_not_elided", MeasurePerformanceStats(options, [] {
+                                                int* p = new int{10};
+                                                DoNotOptimize(p);
+                                                delete p;
+
+                                                return 10;
+                                            }));
+
+    auto const lumped = RecordBenchmark("heap_elision/lump", MeasurePerformanceStats(options, lump));
+
+    std::cout << "emit() elided     : " << elided << std::endl;
+    std::cout << "emit() not elided : " << not_elided << std::endl;
+    std::cout << "lump()            : " << lumped << std::endl;
+
+    ASSERT_DOUBLE_EQ(1.0, *not_elided.allocations_per_op);  // DoNotOptimizeにより、最適化ビルドでも省略されない
+
+#ifdef __OPTIMIZE__  // 最適化ビルドでのみ、省略が起こる
+    ASSERT_DOUBLE_EQ(0.0, *elided.allocations_per_op);
+    ASSERT_LT(elided.min_ns, not_elided.min_ns);
+#else
+    ASSERT_DOUBLE_EQ(1.0, *elided.allocations_per_op);
+#endif
+}
 }  // namespace
@@ -0,0 +1,205 @@
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_gate.h"
+#include "instrumented_lock.h"
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+namespace {
+
+LockSiteStats find_site(std::string const& name)
+{
+    for (auto const& stats : LockProfiler::Instance().Snapshot()) {
+        if (stats.name == name) {
+            return stats;
+        }
+    }
+
+    return LockSiteStats{};
+}
+
+TEST(InstrumentedLock, histogram)
+{
+    auto histogram = LockHistogram{};
+
+    ASSERT_EQ(0, HistogramPercentile(histogram, 50));
+
+    histogram[0] = 1;   // 0ns
+    histogram[4] = 98;  // [8, 16)ns
+    histogram[8] = 1;   // [128, 256)ns
+
+    ASSERT_EQ(16, HistogramPercentile(histogram, 50));
+    ASSERT_EQ(16, HistogramPercentile(histogram, 99));
+    ASSERT_EQ(256, HistogramPercentile(histogram, 100));
+}
+
+TEST(InstrumentedLock, count)
+{
+    InstrumentedLock<SpinLock> lock{"test/count"};
+
+    for (auto i = 0U; i < InstrumentedLock<SpinLock>::hold_sample_period * 2; ++i) {
+        std::lock_guard<InstrumentedLock<SpinLock>> lg{lock};
+    }
+
+    ASSERT_TRUE(lock.try_lock());
+
+    auto locked = true;
+    std::thread{[&lock, &locked] { locked = lock.try_lock(); }}.join();
+    ASSERT_FALSE(locked);  // 失敗したtry_lockは獲得回数に含めない
+
+    lock.unlock();
+
+    auto const stats = find_site("test/count");
+    ASSERT_EQ(33, stats.acquisitions);
+    ASSERT_EQ(0, stats.contentions);
+
+    auto holds = uint64_t{0};
+    for (auto n : stats.hold_histogram) {
+        holds += n;
+    }
+    ASSERT_EQ(2, holds);  // hold_sample_period回に1回だけ保持時間を計測する
+}
+
+TEST(InstrumentedLock, contention)
+{
+    InstrumentedLock<std::mutex> lock{"test/contention"};
+    lock.lock();
+
+    std::thread th{[&lock] { std::lock_guard<InstrumentedLock<std::mutex>> lg{lock}; }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    lock.unlock();
+    th.join();
+
+    auto const stats = find_site("test/contention");
+    ASSERT_EQ(2, stats.acquisitions);
+    ASSERT_EQ(1, stats.contentions);
+    ASSERT_EQ(InstrumentedLock<std::mutex>::max_spin, stats.spin_iterations);  // スピンで獲得できずlockで待った
+    ASSERT_LE(1'000'000, HistogramPercentile(stats.wait_histogram, 100));     // 1ms以上待った
+
+    auto oss = std::ostringstream{};
+    LockProfiler::Instance().Dump(oss);
+    ASSERT_NE(std::string::npos, oss.str().find("test/contention acquisitions:2 contention:0.5"));
+}
+
+// lock_ownership_wrapper_ut.cppのBankAccount、IntQueueのmutexをInstrumentedLockにしたもの
+class BankAccount {
+public:
+    explicit BankAccount(int balance) : balance_{balance} {}
+
+    void transfer(BankAccount& to, int amount)
+    {
+        std::scoped_lock lock{mtx_, to.mtx_};
+
+        if (balance_ >= amount) {
+            balance_ -= amount;
+            to.balance_ += amount;
+        }
+    }
+
+    int balance() const
+    {
+        std::lock_guard<InstrumentedLock<std::mutex>> lock{mtx_};
+        return balance_;
+    }
+
+private:
+    mutable InstrumentedLock<std::mutex> mtx_{"BankAccount"};
+    int                                  balance_;
+};
+
+class IntQueue {
+public:
+    void push(int v)
+    {
+        {
+            std::lock_guard<InstrumentedLock<std::mutex>> lg{mtx_};
+            q_.push(v);
+        }
+
+        cv_.notify_one();
+    }
+
+    int pop()
+    {
+        std::unique_lock<InstrumentedLock<std::mutex>> lock{mtx_};
+        cv_.wait(lock, [&q_ = q_] { return !q_.empty(); });  // std::mutex以外にはcondition_variable_anyを使う
+
+        int v = q_.front();
+        q_.pop();
+        return v;
+    }
+
+private:
+    InstrumentedLock<std::mutex> mtx_{"IntQueue"};
+    std::condition_variable_any  cv_{};
+    std::queue<int>              q_{};
+};
+
+TEST(InstrumentedLock, profile_samples)
+{
+    LockProfiler::Instance().Reset();
+
+    BankAccount acc1{1000};
+    BankAccount acc2{1000};
+    IntQueue    iq{};
+
+    std::thread t1{[&] {
+        for (auto i = 0; i < 1000; ++i) {
+            acc1.transfer(acc2, 100);
+            iq.push(i);
+        }
+    }};
+
+    std::thread t2{[&] {
+        for (auto i = 0; i < 1000; ++i) {
+            acc2.transfer(acc1, 100);
+            ASSERT_EQ(i, iq.pop());
+        }
+    }};
+
+    t1.join();
+    t2.join();
+
+    ASSERT_EQ(2000, acc1.balance() + acc2.balance());
+
+    auto const bank  = find_site("BankAccount");
+    auto const queue = find_site("IntQueue");
+    ASSERT_LE(2 * 2000 + 2, bank.acquisitions);  // transferは2つのロックを獲得する(scoped_lockの再試行分は多くなる)
+    ASSERT_LE(2000, queue.acquisitions);
+
+    LockProfiler::Instance().Dump(std::cout);
+}
+
+TEST(Benchmark, instrumented_lock)
+{
+    auto options           = MeasureOptions{};
+    options.warmup         = 1000;
+    options.samples        = 20;
+    options.ops_per_sample = 10'000;
+
+    SpinLock                   plain{};
+    InstrumentedLock<SpinLock> instrumented{"benchmark/instrumented_lock"};
+
+    auto const plain_stats = RecordBenchmark("instrumented_lock/spin_lock", MeasurePerformanceStats(options, [&plain] {
+                                                 std::lock_guard<SpinLock> lg{plain};
+                                             }));
+
+    auto const instrumented_stats
+        = RecordBenchmark("instrumented_lock/instrumented_spin_lock", MeasurePerformanceStats(options, [&instrumented] {
+                              std::lock_guard<InstrumentedLock<SpinLock>> lg{instrumented};
+                          }));
+
+    std::cout << "SpinLock                   : " << plain_stats << std::endl;
+    std::cout << "InstrumentedLock<SpinLock> : " << instrumented_stats << std::endl;
+}
+}  // namespace
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "suppress_warning.h"
+
+namespace {
+TEST(MeasurePerformance, stats)
+{
+    auto const stats = CalcPerformanceStats({5.0, 1.0, 4.0, 2.0, 3.0}, 10);
+
+    ASSERT_EQ(10, stats.ops_per_sample);
+    ASSERT_EQ((std::vector<double>{1.0, 2.0, 3.0, 4.0, 5.0}), stats.samples_ns);  // 昇順にソートされる
+    ASSERT_DOUBLE_EQ(1.0, stats.min_ns);
+    ASSERT_DOUBLE_EQ(3.0, stats.median_ns);
+    ASSERT_DOUBLE_EQ(3.0, stats.mean_ns);
+    ASSERT_DOUBLE_EQ(4.6, stats.p90_ns);
+    ASSERT_DOUBLE_EQ(4.96, stats.p99_ns);
+    ASSERT_DOUBLE_EQ(std::sqrt(2.5), stats.stddev_ns);
+
+    auto const empty = CalcPerformanceStats({}, 10);
+    ASSERT_TRUE(empty.samples_ns.empty());
+    ASSERT_DOUBLE_EQ(0.0, empty.mean_ns);
+}
+
+TEST(MeasurePerformance, measure)
+{
+    auto options           = MeasureOptions{};
+    options.warmup         = 3;
+    options.samples        = 4;
+    options.ops_per_sample = 5;
+
+    auto count = 0U;
+    auto stats = MeasurePerformanceStats(options, [&count] { ++count; });
+
+    ASSERT_EQ(3 + 4 * 5, count);
+    ASSERT_EQ(4, stats.samples_ns.size());
+    ASSERT_EQ(5, stats.ops_per_sample);
+    ASSERT_LE(stats.min_ns, stats.median_ns);
+    ASSERT_LE(stats.median_ns, stats.p90_ns);
+    ASSERT_LE(stats.p90_ns, stats.p99_ns);
+
+    // ミリ秒未満の処理でも1オペレーションあたりの時間がナノ秒単位で得られる
+    options.warmup         = 0;
+    options.samples        = 3;
+    options.ops_per_sample = 2;
+
+    auto sleep = MeasurePerformanceStats(options, [] { std::this_thread::sleep_for(std::chrono::microseconds{100}); });
+    ASSERT_GE(sleep.min_ns, 100'000.0);
+    ASSERT_FALSE(sleep.counters_per_op);  // perf_countersを指定しなければカウンタは取得しない
+}
+
+TEST(MeasurePerformance, perf_counter_values)
+{
+    auto values         = PerfCounterValues{};
+    values.cycles       = 200.0;
+    values.instructions = 400.0;
+
+    values /= 100.0;
+
+    ASSERT_DOUBLE_EQ(2.0, *values.cycles);
+    ASSERT_DOUBLE_EQ(4.0, *values.instructions);
+    ASSERT_DOUBLE_EQ(2.0, *values.ipc());
+    ASSERT_FALSE(values.cache_misses);  // 取得されていないカウンタはstd::nulloptのまま
+
+    values.cycles.reset();
+    ASSERT_FALSE(values.ipc());
+}
+
+TEST(MeasurePerformance, perf_counters)
+{
+    auto options           = MeasureOptions{};
+    options.warmup         = 10;
+    options.samples        = 10;
+    options.ops_per_sample = 1000;
+    options.perf_counters  = true;
+
+    auto sum   = 0U;
+    auto stats = MeasurePerformanceStats(options, [&sum] {
+        for (auto i = 0U; i < 100; ++i) {
+            sum += i;
+        }
+        return sum;
+    });
+
+    PerfCounters counters;
+
+    if (counters.is_available()) {
+        ASSERT_TRUE(stats.counters_per_op);
+
+        if (auto instructions = stats.counters_per_op->instructions; instructions) {
+            ASSERT_GT(*instructions, 0.0);
+        }
+    }
+    else {  // perf_event_paranoid等で許可されない環境では、カウンタなしで計測だけが行われる
+        ASSERT_FALSE(stats.counters_per_op);
+    }
+
+    ASSERT_EQ(10, stats.samples_ns.size());
+}
+}  // namespace
+
+namespace {
+TEST(MeasureContention, measure)
+{
+    auto options           = ContentionOptions{};
+    options.threads        = 3;
+    options.ops_per_thread = 1000;
+    options.pin_threads    = true;
+
+    auto count = std::atomic<uint32_t>{0};
+    auto stats = MeasureContention(options, [&count] { ++count; });
+
+    ASSERT_EQ(3000, count);
+    ASSERT_EQ(3, stats.threads);
+    ASSERT_EQ(3000, stats.total_ops);
+    ASSERT_EQ(3, stats.thread_elapsed_ns.size());
+    ASSERT_LE(stats.fastest_ns, stats.slowest_ns);
+    ASSERT_DOUBLE_EQ(stats.slowest_ns, stats.elapsed_ns);
+    ASSERT_GT(stats.ops_per_sec, 0.0);
+    ASSERT_GE(stats.unfairness(), 0.0);
+    ASSERT_LE(stats.unfairness(), 1.0);
+}
+
+TEST(MeasureContention, sweep)
+{
+    auto count = std::atomic<uint32_t>{0};
+    auto stats = SweepContention(100, [&count] { ++count; }, 5);
+
+    ASSERT_EQ(4, stats.size());  // 1, 2, 4, 5スレッド
+    ASSERT_EQ(1, stats[0].threads);
+    ASSERT_EQ(2, stats[1].threads);
+    ASSERT_EQ(4, stats[2].threads);
+    ASSERT_EQ(5, stats[3].threads);
+    ASSERT_EQ((1 + 2 + 4 + 5) * 100, count);
+}
+}  // namespace
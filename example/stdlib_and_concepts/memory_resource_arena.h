@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+#include "memory_resource_variable.h"
+#include "scoped_guard.h"
+#include "suppress_warning.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+/// @brief memory_resource_arenaの確保位置を示すマーカー。rollbackでこの位置まで巻き戻す
+struct arena_marker_t {
+    size_t offset;
+};
+
+/// @brief 固定長バッファ上でポインタを進めるだけの単調増加(bump pointer)のメモリリソース
+/// @details deallocateは何もせず、確保した領域はrollback/releaseでまとめて解放する。
+///          リクエスト処理などの短命なオブジェクトを多数生成し、最後にすべて破棄する用途では、
+///          オブジェクト毎の解放コストがなくなる。
+///          1つのスレッドから使うことを前提とし、排他制御は行わない。
+template <uint32_t MEM_SIZE>
+class memory_resource_arena final : public std::pmr::memory_resource {
+public:
+    memory_resource_arena() noexcept = default;
+
+    memory_resource_arena(memory_resource_arena const&)            = delete;
+    memory_resource_arena& operator=(memory_resource_arena const&) = delete;
+
+    size_t get_count() const noexcept { return sizeof(buff_.buffer) - offset_; }
+    bool   is_valid(void const* mem) const noexcept
+    {
+        return (&buff_ <= mem) && (mem < &buff_.buffer[ArrayLength(buff_.buffer)]);
+    }
+
+    /// @brief 現在の確保位置を返す
+    arena_marker_t checkpoint() const noexcept { return arena_marker_t{offset_}; }
+
+    /// @brief markerを取得した後に確保した領域をすべて解放する
+    /// @details 解放した領域を使うオブジェクトは、呼び出し前に破棄しなければならない
+    void rollback(arena_marker_t marker) noexcept
+    {
+        assert(marker.offset <= offset_);
+        offset_ = marker.offset;
+    }
+
+    /// @brief 確保した領域をすべて解放する
+    void release() noexcept { offset_ = 0; }
+
+    /// @brief スコープの終了時に、呼び出し時点の確保位置へ巻き戻すNstd::ScopedGuardを返す
+    /// @details 戻り値より後に生成したオブジェクトは、戻り値より先に破棄される
+    auto scoped_rollback() noexcept
+    {
+        return Nstd::ScopedGuard{[this, marker = checkpoint()]() noexcept { rollback(marker); }};
+    }
+
+private:
+    Inner_::buffer_t<MEM_SIZE> buff_{};
+    size_t                     offset_{0};
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        auto const addr    = reinterpret_cast<uintptr_t>(buff_.buffer) + offset_;
+        auto const aligned = (addr + alignment - 1) & ~(alignment - 1);
+        auto const offset  = aligned - reinterpret_cast<uintptr_t>(buff_.buffer);
+
+        // 大きなアライメントでoffsetがバッファを超える場合や、offset + sizeのラップアラウンドも拒否する
+        if (offset > sizeof(buff_.buffer) || size > sizeof(buff_.buffer) - offset) {
+            throw std::bad_alloc{};
+        }
+
+        offset_ = offset + size;
+
+        return buff_.buffer + offset;
+    }
+
+    void do_deallocate(void*, size_t, size_t) noexcept override {}
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+SUPPRESS_WARN_END;
@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_gate.h"
+#include "measure_performance.h"
+#include "memory_resource_arena.h"
+#include "memory_resource_variable.h"
+#include "suppress_warning.h"
+
+namespace {
+
+using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+
+TEST(NewDelete, memory_resource_arena)
+{
+    memory_resource_arena<1024> mra;
+    auto const                  count = mra.get_count();
+
+    {
+        pmr_string str("custom allocator!", &mra);
+        ASSERT_TRUE(mra.is_valid(str.c_str()));
+        ASSERT_GT(count, mra.get_count());
+
+        // operator+の戻り値のアロケータはselect_on_container_copy_constructionにより
+        // デフォルトのメモリリソースとなるため、+=で連結する
+        auto str3 = pmr_string{str, &mra};
+        str3 += str;
+        str3 += str;
+        ASSERT_EQ(str.size() * 3, str3.size());
+        ASSERT_TRUE(mra.is_valid(str3.c_str()));
+
+        ASSERT_THROW(str3 = pmr_string(2000, 'a'), std::bad_alloc);  // メモリの枯渇テスト
+    }
+    ASSERT_GT(count, mra.get_count());  // deallocateでは解放されない
+
+    mra.release();
+    ASSERT_EQ(count, mra.get_count());
+
+    void* p0 = mra.allocate(1);
+    void* p1 = mra.allocate(8, 64);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(p1) % 64);
+    ASSERT_LT(p0, p1);
+
+    // offset + sizeのラップアラウンドや、アライメントでバッファを超える要求は確保してはならない
+    auto const rest = mra.get_count();
+    for (auto huge : {SIZE_MAX, SIZE_MAX - 64}) {
+        DoNotOptimize(huge);  // 定数のままでは-Walloc-size-larger-thanとなる
+        ASSERT_THROW(DoNotOptimize(mra.allocate(huge)), std::bad_alloc);
+    }
+    ASSERT_THROW(DoNotOptimize(mra.allocate(1, 1 << 20)), std::bad_alloc);
+    ASSERT_EQ(rest, mra.get_count());
+}
+
+TEST(NewDelete, memory_resource_arena_rollback)
+{
+    memory_resource_arena<1024> mra;
+
+    auto v = std::pmr::vector<int>{{1, 2, 3}, &mra};  // 巻き戻しの対象外
+    auto const count = mra.get_count();
+
+    auto const marker = mra.checkpoint();
+    DoNotOptimize(mra.allocate(100));
+    ASSERT_GT(count, mra.get_count());
+
+    mra.rollback(marker);
+    ASSERT_EQ(count, mra.get_count());
+
+    {
+        auto guard = mra.scoped_rollback();  // スコープの終了時にこの位置まで巻き戻す
+
+        auto str = pmr_string{"request scoped string", &mra};
+        auto ws  = std::pmr::vector<pmr_string>{&mra};
+        ws.emplace_back("a");
+        ws.emplace_back("b");
+
+        ASSERT_GT(count, mra.get_count());
+    }  // str、ws、guardの順に破棄される
+    ASSERT_EQ(count, mra.get_count());
+
+    ASSERT_EQ((std::pmr::vector<int>{1, 2, 3}), v);
+}
+
+/// @brief pmr_memory_resource_ut.cppの文字列の連結を、1リクエスト分として繰り返す
+void concat_strings(std::pmr::memory_resource& mr)
+{
+    auto str  = pmr_string{"custom allocator!", &mr};
+    auto strs = std::pmr::vector<pmr_string>{&mr};
+
+    for (auto i = 0; i < 8; ++i) {
+        auto& str3 = strs.emplace_back(str);
+        str3 += str;
+        str3 += str;
+        DoNotOptimize(str3.data());
+    }
+}
+
+TEST(Benchmark, memory_resource_arena)
+{
+    constexpr uint32_t max = 4096;
+
+    auto options           = MeasureOptions{};
+    options.warmup         = 100;
+    options.samples        = 20;
+    options.ops_per_sample = 1000;
+    options.perf_counters  = true;
+
+    memory_resource_arena<max> mra;
+    auto const                 count = mra.get_count();
+
+    auto const arena = RecordBenchmark("concat/memory_resource_arena", MeasurePerformanceStats(options, [&mra] {
+                                           auto guard = mra.scoped_rollback();
+                                           concat_strings(mra);
+                                       }));
+
+    memory_resource_variable<max> mrv;
+    auto const mrv_stats = RecordBenchmark("concat/memory_resource_variable",
+                                           MeasurePerformanceStats(options, [&mrv] { concat_strings(mrv); }));
+
+    auto       pool       = std::pmr::unsynchronized_pool_resource{};
+    auto const pool_stats = RecordBenchmark("concat/unsynchronized_pool_resource",
+                                            MeasurePerformanceStats(options, [&pool] { concat_strings(pool); }));
+
+    std::cout << "memory_resource_arena            : " << arena << std::endl;
+    std::cout << "memory_resource_variable         : " << mrv_stats << std::endl;
+    std::cout << "unsynchronized_pool_resource     : " << pool_stats << std::endl;
+
+    ASSERT_EQ(count, mra.get_count());
+}
+}  // namespace
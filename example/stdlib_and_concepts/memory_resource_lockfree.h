@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+#include "spin_lock.h"
+#include "suppress_warning.h"
+#include "utils.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+/// @brief 固定長ブロックのフリーリストを、ロックフリーのTreiberスタックで管理するメモリリソース
+/// @details スタックの先頭は(ブロックの添字, タグ)を1つの64ビットのアトミック変数に詰めたタグ付きポインタであり、
+///          pushとpopの度にタグを進めることで、CAS中に先頭がA->B->Aと変化するABA問題を避ける
+///          (タグが2^32回一巡するまでCASが遅延しない限り安全)。
+///          空きブロックの先頭には次の空きブロックの添字を置く。popは他スレッドが確保済みのブロックの先頭を
+///          読むことがあるが、その場合は先頭のタグが変わっているためCASが失敗し、読んだ値は使われない。
+///          BLOCK_SIZEを超えるサイズ、max_align_tを超えるアライメントの要求はstd::bad_allocとなる。
+template <size_t BLOCK_SIZE, uint32_t N_BLOCKS>
+class memory_resource_lockfree final : public std::pmr::memory_resource {
+public:
+    static constexpr size_t block_size
+        = Roundup(alignof(std::max_align_t), std::max(BLOCK_SIZE, sizeof(std::atomic<uint32_t>)));
+
+    memory_resource_lockfree() noexcept
+    {
+        for (auto i = 0U; i < N_BLOCKS; ++i) {
+            new (block(i)) std::atomic<uint32_t>{i + 1 < N_BLOCKS ? i + 1 : null_index};
+        }
+    }
+
+    memory_resource_lockfree(memory_resource_lockfree const&)            = delete;
+    memory_resource_lockfree& operator=(memory_resource_lockfree const&) = delete;
+
+    size_t get_count() const noexcept { return free_blocks_.load(std::memory_order_relaxed) * block_size; }
+    bool   is_valid(void const* mem) const noexcept
+    {
+        return (buff_ <= mem) && (mem < &buff_[ArrayLength(buff_)]);
+    }
+
+private:
+    static constexpr uint32_t null_index = ~0U;
+
+    alignas(cache_line_size) uint8_t buff_[block_size * N_BLOCKS];
+    alignas(cache_line_size) std::atomic<uint64_t> head_{pack(N_BLOCKS == 0 ? null_index : 0, 0)};
+    alignas(cache_line_size) std::atomic<uint32_t> free_blocks_{N_BLOCKS};  // head_と別のキャッシュラインに置く
+
+    static constexpr uint64_t pack(uint32_t index, uint32_t tag) noexcept { return (uint64_t{tag} << 32) | index; }
+    static constexpr uint32_t index_of(uint64_t head) noexcept { return static_cast<uint32_t>(head); }
+    static constexpr uint32_t tag_of(uint64_t head) noexcept { return static_cast<uint32_t>(head >> 32); }
+
+    uint8_t* block(uint32_t index) noexcept { return buff_ + index * block_size; }
+
+    std::atomic<uint32_t>& next_of(uint32_t index) noexcept
+    {
+        return *std::launder(reinterpret_cast<std::atomic<uint32_t>*>(block(index)));
+    }
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        if (size > block_size || alignment > alignof(std::max_align_t)) {
+            throw std::bad_alloc{};
+        }
+
+        auto head = head_.load(std::memory_order_acquire);
+
+        for (;;) {
+            auto const index = index_of(head);
+            if (index == null_index) {
+                throw std::bad_alloc{};
+            }
+
+            auto const next = next_of(index).load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, pack(next, tag_of(head) + 1), std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                free_blocks_.fetch_sub(1, std::memory_order_relaxed);
+                return block(index);
+            }
+        }
+    }
+
+    void do_deallocate(void* mem, size_t, size_t) noexcept override
+    {
+        auto const index = static_cast<uint32_t>((static_cast<uint8_t*>(mem) - buff_) / block_size);
+        auto&      next  = *new (mem) std::atomic<uint32_t>{};  // ユーザの使用後、改めてアトミック変数を生成する
+
+        auto head = head_.load(std::memory_order_relaxed);
+        do {
+            next.store(index_of(head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head, pack(index, tag_of(head) + 1), std::memory_order_release,
+                                              std::memory_order_relaxed));
+
+        free_blocks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+SUPPRESS_WARN_END;
@@ -0,0 +1,128 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "memory_resource_lockfree.h"
+#include "memory_resource_variable.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+namespace {
+
+TEST(NewDelete, memory_resource_lockfree)
+{
+    memory_resource_lockfree<64, 4> mrl;
+    auto const                      count = mrl.get_count();
+
+    ASSERT_EQ(4 * 64, count);
+
+    void* ps[4];
+    for (auto& p : ps) {
+        p = mrl.allocate(64);
+        ASSERT_TRUE(mrl.is_valid(p));
+        std::memset(p, 0xff, 64);  // 空きリストの添字を上書きしても問題ない
+    }
+    ASSERT_EQ(0, mrl.get_count());
+    ASSERT_THROW(DoNotOptimize(mrl.allocate(8)), std::bad_alloc);  // メモリの枯渇テスト
+
+    for (auto* p : ps) {
+        mrl.deallocate(p, 64);
+    }
+    ASSERT_EQ(count, mrl.get_count());
+
+    ASSERT_THROW(DoNotOptimize(mrl.allocate(65)), std::bad_alloc);      // ブロックより大きい
+    ASSERT_THROW(DoNotOptimize(mrl.allocate(8, 64)), std::bad_alloc);  // max_align_tを超えるアライメント
+}
+
+TEST(NewDelete, memory_resource_lockfree_pmr)
+{
+    memory_resource_lockfree<64, 128> mrl;
+    auto const                        count = mrl.get_count();
+
+    {
+        auto list = std::pmr::list<int>{&mrl};  // ノードは固定長
+        for (auto i = 0; i < 100; ++i) {
+            list.push_back(i);
+        }
+        ASSERT_EQ(99, list.back());
+        ASSERT_EQ(count - 100 * mrl.block_size, mrl.get_count());
+    }
+    ASSERT_EQ(count, mrl.get_count());
+}
+
+TEST(NewDelete, memory_resource_lockfree_threads)
+{
+    constexpr auto threads = 4U;
+    constexpr auto blocks  = 64U;
+
+    auto mrl   = std::make_unique<memory_resource_lockfree<64, threads * blocks>>();
+    auto count = mrl->get_count();
+
+    // 各スレッドは確保したブロックに自分の番号を書き込み、解放前に他のスレッドに上書きされていないことを確かめる
+    auto worker = [&mrl](uint64_t id, bool& ok) {
+        auto ps = std::vector<uint64_t*>(blocks / 2);
+
+        for (auto i = 0; i < 2000; ++i) {
+            for (auto& p : ps) {
+                p  = static_cast<uint64_t*>(mrl->allocate(64));
+                *p = id;
+            }
+            for (auto* p : ps) {
+                ok = ok && *p == id;
+                mrl->deallocate(p, 64);
+            }
+        }
+    };
+
+    bool oks[threads]{true, true, true, true};
+    auto ts = std::vector<std::thread>{};
+    for (auto i = 0U; i < threads; ++i) {
+        ts.emplace_back(worker, i, std::ref(oks[i]));
+    }
+    for (auto& t : ts) {
+        t.join();
+    }
+
+    for (auto ok : oks) {
+        ASSERT_TRUE(ok);
+    }
+    ASSERT_EQ(count, mrl->get_count());
+}
+
+template <typename MR>
+void measure_fixed_contention(MR& mr, char const* name)
+{
+    auto const count = mr.get_count();
+
+    for (auto threads : {1U, 2U, 4U}) {
+        auto const stats = MeasureContention(ContentionOptions{threads, 20'000, true}, [&mr] {
+            void* p = mr.allocate(64);
+            DoNotOptimize(p);
+            mr.deallocate(p, 64);
+        });
+
+        std::cout << name << stats << std::endl;
+    }
+
+    ASSERT_EQ(count, mr.get_count());
+}
+
+TEST(Benchmark, memory_resource_lockfree)
+{
+    auto mrv = std::make_unique<memory_resource_variable<64 * 1024, SpinLock>>();
+    auto mrl = std::make_unique<memory_resource_lockfree<64, 1024>>();
+
+    measure_fixed_contention(*mrv, "memory_resource_variable<SpinLock> ");
+    measure_fixed_contention(*mrl, "memory_resource_lockfree           ");
+}
+}  // namespace
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "memory_resource_tlsf.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+/// @brief memory_resource_mmapの生成オプション
+struct mmap_options_t {
+    size_t reserve_bytes{size_t{1} << 30};  ///< 予約する仮想アドレス空間のサイズ
+    bool   huge_pages{true};                ///< ヒュージページ(MAP_HUGETLB、またはTransparent Huge Page)を使う
+};
+
+namespace Inner_ {
+
+constexpr size_t huge_page_size = size_t{2} << 20;  // x86_64、aarch64(4KiBページ)のヒュージページ
+
+inline size_t page_size() noexcept
+{
+    static auto const size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+inline uintptr_t align_up(uintptr_t v, size_t align) noexcept { return (v + align - 1) & ~(align - 1); }
+inline uintptr_t align_down(uintptr_t v, size_t align) noexcept { return v & ~(align - 1); }
+}  // namespace Inner_
+
+/// @brief mmapで予約した大きな仮想アドレス空間上に、TLSFアルゴリズム(Inner_::tlsf_heap_t)のヒープを置くメモリリソース
+/// @details MAP_NORESERVEで予約するため、物理メモリは最初にアクセスされたページから遅延して割り当てられる。
+///          huge_pagesが指定された場合、MAP_HUGETLBでの予約を試み、ヒュージページが用意されていなければ
+///          通常のページで予約してmadvise(MADV_HUGEPAGE)によりTransparent Huge Pageを要求する。
+///          ヒュージページによりTLBミスが減るため、大きなデータをランダムにアクセスする場合に有効である。
+///          trim()は空きブロック内のページをmadvise(MADV_DONTNEED)でOSに返す。
+///          アイドル時など、リアルタイム性が不要なタイミングで呼び出す。
+///          reserve_bytesがInner_::tlsf_max_heap_size(512GiB)を超える場合、コンストラクタはstd::bad_allocを送出する。
+template <typename LOCK = SpinLock>
+class memory_resource_mmap final : public std::pmr::memory_resource {
+public:
+    explicit memory_resource_mmap(mmap_options_t const& options = mmap_options_t{})
+        : map_size_{map_size(options)},
+          map_{map(options.huge_pages)},
+          heap_{base(), map_size_}
+    {
+    }
+
+    ~memory_resource_mmap() override { ::munmap(map_, map_length()); }
+
+    memory_resource_mmap(memory_resource_mmap const&)            = delete;
+    memory_resource_mmap& operator=(memory_resource_mmap const&) = delete;
+
+    size_t get_count() const noexcept
+    {
+        auto lock = std::lock_guard{lock_};
+        return heap_.get_count();
+    }
+
+    bool is_valid(void const* mem) const noexcept
+    {
+        return (map_ <= mem) && (mem < static_cast<uint8_t const*>(map_) + map_length());
+    }
+
+    tlsf_stats_t get_stats() const noexcept
+    {
+        auto lock = std::lock_guard{lock_};
+        return heap_.get_stats();
+    }
+
+    /// @brief MAP_HUGETLB、またはMADV_HUGEPAGEによりヒュージページを要求できた場合、true
+    bool uses_huge_pages() const noexcept { return huge_page_mode_ != huge_page_mode::none; }
+
+    /// @brief 予約した領域のうち、物理メモリが割り当てられているバイト数
+    size_t get_resident() const
+    {
+        auto const page = Inner_::page_size();
+        auto       vec  = std::vector<unsigned char>((map_length() + page - 1) / page);
+
+        if (::mincore(map_, map_length(), vec.data()) != 0) {
+            return 0;
+        }
+
+        auto resident = size_t{0};
+        for (auto v : vec) {
+            resident += (v & 1) * page;
+        }
+
+        return resident;
+    }
+
+    /// @brief 空きブロック内のページをOSに返す
+    /// @return 返却を要求したバイト数
+    size_t trim() noexcept
+    {
+        // MAP_HUGETLBの領域はヒュージページ単位でしか返却できない
+        // THPの領域は通常のページ単位で返却できるが、ヒュージページが分割される
+        auto const granularity
+            = huge_page_mode_ == huge_page_mode::hugetlb ? Inner_::huge_page_size : Inner_::page_size();
+
+        auto lock     = std::lock_guard{lock_};
+        auto released = size_t{0};
+
+        heap_.for_each_block([&](Inner_::tlsf_block_t const* block, size_t size, bool is_free) {
+            if (!is_free) {
+                return;
+            }
+
+            // 空きブロックのヘッダとフリーリストのリンク、後続ブロックのヘッダは残す
+            auto const addr  = reinterpret_cast<uintptr_t>(block);
+            auto const first = Inner_::align_up(addr + sizeof(Inner_::tlsf_block_t), granularity);
+            auto const last  = Inner_::align_down(addr + size, granularity);
+
+            if (first < last && ::madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED) == 0) {
+                released += last - first;
+            }
+        });
+
+        return released;
+    }
+
+private:
+    enum class huge_page_mode { none, hugetlb, transparent };
+
+    size_t const        map_size_;
+    huge_page_mode      huge_page_mode_{huge_page_mode::none};
+    void* const         map_;
+    mutable LOCK        lock_{};
+    Inner_::tlsf_heap_t heap_;
+
+    // THPはヒュージページ境界に整列した領域にしか適用されないため、その分を余分に予約する
+    size_t map_length() const noexcept
+    {
+        return huge_page_mode_ == huge_page_mode::transparent ? map_size_ + Inner_::huge_page_size : map_size_;
+    }
+
+    uint8_t* base() const noexcept
+    {
+        auto const addr = reinterpret_cast<uintptr_t>(map_);
+
+        return reinterpret_cast<uint8_t*>(huge_page_mode_ == huge_page_mode::transparent
+                                              ? Inner_::align_up(addr, Inner_::huge_page_size)
+                                              : addr);
+    }
+
+    /// @brief 予約するサイズ。TLSFのヒープが管理できないサイズの場合、std::bad_allocを送出する
+    static size_t map_size(mmap_options_t const& options)
+    {
+        if (options.reserve_bytes > Inner_::tlsf_max_heap_size) {
+            throw std::bad_alloc{};
+        }
+
+        // tlsf_max_heap_sizeはヒュージページ境界のため、切り上げても上限を超えない
+        return Inner_::align_up(options.reserve_bytes,
+                                options.huge_pages ? Inner_::huge_page_size : Inner_::page_size());
+    }
+
+    void* map(bool huge_pages)
+    {
+        constexpr auto prot  = PROT_READ | PROT_WRITE;
+        constexpr auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+
+        if (huge_pages) {
+#ifdef MAP_HUGETLB
+            // MAP_NORESERVEを指定すると、ヒュージページが不足していてもmmapが成功し、アクセス時にSIGBUSとなる。
+            // 指定しなければ、予約したヒュージページ数が不足する場合にmmapが失敗する
+            auto const hugetlb_flags = (flags & ~MAP_NORESERVE) | MAP_HUGETLB;
+            if (auto* mem = ::mmap(nullptr, map_size_, prot, hugetlb_flags, -1, 0); mem != MAP_FAILED) {
+                huge_page_mode_ = huge_page_mode::hugetlb;
+                return mem;
+            }
+#endif
+#ifdef MADV_HUGEPAGE
+            auto const length = map_size_ + Inner_::huge_page_size;
+            if (auto* mem = ::mmap(nullptr, length, prot, flags, -1, 0); mem != MAP_FAILED) {
+                auto const aligned = Inner_::align_up(reinterpret_cast<uintptr_t>(mem), Inner_::huge_page_size);
+                if (::madvise(reinterpret_cast<void*>(aligned), map_size_, MADV_HUGEPAGE) == 0) {
+                    huge_page_mode_ = huge_page_mode::transparent;
+                    return mem;
+                }
+                ::munmap(mem, length);
+            }
+#endif
+        }
+
+        if (auto* mem = ::mmap(nullptr, map_size_, prot, flags, -1, 0); mem != MAP_FAILED) {
+            return mem;
+        }
+
+        throw std::bad_alloc{};
+    }
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        if (alignment > Inner_::tlsf_align) {
+            throw std::bad_alloc{};
+        }
+
+        auto lock = std::lock_guard{lock_};
+
+        if (auto* mem = heap_.allocate(size); mem != nullptr) {
+            return mem;
+        }
+
+        throw std::bad_alloc{};
+    }
+
+    void do_deallocate(void* mem, size_t, size_t) noexcept override
+    {
+        auto lock = std::lock_guard{lock_};
+        heap_.deallocate(mem);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+SUPPRESS_WARN_END;
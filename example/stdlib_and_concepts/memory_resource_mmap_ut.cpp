@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_gate.h"
+#include "measure_performance.h"
+#include "memory_resource_mmap.h"
+#include "suppress_warning.h"
+
+namespace {
+
+TEST(NewDelete, memory_resource_mmap)
+{
+    constexpr size_t reserve = 64 << 20;
+
+    auto options          = mmap_options_t{};
+    options.reserve_bytes = reserve;
+
+    auto       mrm   = memory_resource_mmap<>{options};
+    auto const count = mrm.get_count();
+
+    ASSERT_GE(reserve, count);
+    ASSERT_LT(mrm.get_resident(), 16 << 20);  // 予約しただけでは物理メモリは割り当てられない
+
+    {
+        auto v = std::pmr::vector<uint64_t>{&mrm};
+
+        for (auto i = 0U; i < (16 << 20) / sizeof(uint64_t); ++i) {
+            v.push_back(i);
+        }
+
+        ASSERT_TRUE(mrm.is_valid(v.data()));
+        ASSERT_EQ(uint64_t{12345}, v[12345]);
+        ASSERT_LE(16 << 20, mrm.get_resident());
+    }
+    ASSERT_EQ(count, mrm.get_count());
+    ASSERT_EQ(1, mrm.get_stats().free_blocks);
+
+    auto const resident = mrm.get_resident();
+    ASSERT_LT(0, mrm.trim());  // vectorの再確保で使われたページをOSに返す
+    ASSERT_GT(resident, mrm.get_resident());
+    ASSERT_EQ(count, mrm.get_count());
+
+    {
+        auto v = std::pmr::vector<uint64_t>(1024, 7, &mrm);  // trim後も再利用できる
+        ASSERT_EQ(7 * 1024, std::accumulate(v.begin(), v.end(), uint64_t{0}));
+    }
+    ASSERT_EQ(count, mrm.get_count());
+
+    ASSERT_THROW(DoNotOptimize(mrm.allocate(reserve)), std::bad_alloc);
+    ASSERT_THROW(DoNotOptimize(mrm.allocate(16, 64)), std::bad_alloc);  // max_align_tを超えるアライメントは未対応
+}
+
+TEST(NewDelete, memory_resource_mmap_no_huge_pages)
+{
+    auto options          = mmap_options_t{};
+    options.reserve_bytes = 1 << 20;
+    options.huge_pages    = false;
+
+    auto mrm = memory_resource_mmap<>{options};
+
+    ASSERT_FALSE(mrm.uses_huge_pages());
+
+    void* p = mrm.allocate(4096);
+    ASSERT_TRUE(mrm.is_valid(p));
+    mrm.deallocate(p, 4096);
+}
+
+TEST(NewDelete, memory_resource_mmap_oversized_reserve)
+{
+    auto options = mmap_options_t{};
+
+    options.reserve_bytes = Inner_::tlsf_max_heap_size + 1;
+    ASSERT_THROW(memory_resource_mmap<>{options}, std::bad_alloc);
+
+    options.reserve_bytes = SIZE_MAX;  // 切り上げでラップアラウンドしない
+    ASSERT_THROW(memory_resource_mmap<>{options}, std::bad_alloc);
+
+    options.huge_pages = false;
+    ASSERT_THROW(memory_resource_mmap<>{options}, std::bad_alloc);
+}
+
+/// @brief mrから確保した大きな配列へのランダムアクセスを計測する。ヒュージページの効果はTLBミスの減少として現れる
+void measure_random_access(std::pmr::memory_resource& mr, char const* name)
+{
+    constexpr size_t n = (256 << 20) / sizeof(uint64_t);
+
+    auto v   = std::pmr::vector<uint64_t>(n, 1, &mr);
+    auto rng = std::mt19937_64{1};
+    auto sum = uint64_t{0};
+
+    auto options           = MeasureOptions{};
+    options.warmup         = 1000;
+    options.samples        = 20;
+    options.ops_per_sample = 10'000;
+    options.perf_counters  = true;
+
+    auto const stats = RecordBenchmark(name, MeasurePerformanceStats(options, [&] { sum += v[rng() % n]; }));
+
+    DoNotOptimize(sum);
+    std::cout << name << " : " << stats << std::endl;
+}
+
+TEST(Benchmark, memory_resource_mmap)
+{
+    constexpr size_t reserve = 512 << 20;
+
+    auto options          = mmap_options_t{};
+    options.reserve_bytes = reserve;
+
+    options.huge_pages = true;
+    auto huge          = memory_resource_mmap<>{options};
+
+    options.huge_pages = false;
+    auto small         = memory_resource_mmap<>{options};
+
+    std::cout << "uses_huge_pages : " << huge.uses_huge_pages() << std::endl;
+
+    measure_random_access(huge, "random_access/memory_resource_mmap<huge_pages>");
+    measure_random_access(small, "random_access/memory_resource_mmap");
+
+    ASSERT_LT(0, huge.trim());
+    ASSERT_LT(0, small.trim());
+}
+}  // namespace
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_resource_tracing.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+/// @brief replay_alloc_traceの結果
+struct replay_stats_t {
+    size_t   events{0};           ///< 再生したイベント数
+    size_t   threads{0};          ///< 再生したスレッド数
+    uint64_t elapsed_ns{0};       ///< 全イベントの再生に要した時間
+    size_t   failures{0};         ///< std::bad_allocとなった確保の数
+    size_t   peak_live_bytes{0};  ///< トレース中の確保中のバイト数(要求サイズの合計)の最大値
+    size_t   peak_footprint{0};   ///< メモリリソースが使用したメモリの最大値。不明なら0
+
+    /// @brief 1秒当たりのイベント数
+    double throughput() const noexcept { return elapsed_ns == 0 ? 0.0 : events * 1e9 / elapsed_ns; }
+
+    /// @brief 1 - peak_live_bytes / peak_footprint。ヘッダ、アライメント、断片化による無駄の割合
+    double fragmentation() const noexcept
+    {
+        return peak_footprint == 0 ? 0.0 : 1.0 - static_cast<double>(peak_live_bytes) / peak_footprint;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, replay_stats_t const& stats)
+{
+    return os << "events:" << stats.events << " threads:" << stats.threads << " throughput:" << stats.throughput()
+              << "ops/s failures:" << stats.failures << " peak_live:" << stats.peak_live_bytes
+              << "bytes peak_footprint:" << stats.peak_footprint << "bytes fragmentation:" << stats.fragmentation();
+}
+
+namespace Inner_ {
+
+/// @brief トレースのイベントを、スレッド毎の再生順と確保/解放の対応(idを0からの連番にした添字)に分解したもの
+struct replay_plan_t {
+    struct step_t {
+        alloc_event_t const* event;
+        size_t               slot;
+    };
+
+    std::map<uint32_t, std::vector<step_t>> threads{};  // スレッド毎の再生順
+    size_t                                  slots{0};
+    size_t                                  peak_live_bytes{0};
+};
+
+inline replay_plan_t make_replay_plan(std::vector<alloc_event_t> const& events)
+{
+    auto plan  = replay_plan_t{};
+    auto slots = std::unordered_map<uint64_t, size_t>{};
+    auto live  = size_t{0};
+
+    for (auto const& e : events) {
+        if (e.kind == alloc_kind::allocate) {
+            auto const slot = plan.slots++;
+            slots[e.id]     = slot;
+            plan.threads[e.thread].push_back({&e, slot});
+
+            live += e.size;
+            plan.peak_live_bytes = std::max(plan.peak_live_bytes, live);
+        }
+        else if (auto it = slots.find(e.id); it != slots.end()) {  // トレース開始前に確保された領域は無視する
+            plan.threads[e.thread].push_back({&e, it->second});
+            slots.erase(it);
+
+            live -= e.size;
+        }
+    }
+
+    return plan;
+}
+}  // namespace Inner_
+
+/// @brief 記録したアロケーショントレースでmrを駆動し、スループットとメモリ使用量を計測する
+/// @details トレースのスレッド毎にスレッドを生成し、各スレッドはそのスレッドのイベントを記録順に実行する。
+///          他のスレッドが確保した領域の解放は、その確保が実行されるまで待つ。
+///          イベント間の時間は再現せず、最大の速度で再生する。
+///          トレース終了時に解放されていない領域は、計測の後に解放する。
+/// @param peak_footprint 再生後に呼び出し、mrが使用したメモリの最大値を返す関数。空ならpeak_footprintは0
+inline replay_stats_t replay_alloc_trace(std::vector<alloc_event_t> const& events, std::pmr::memory_resource& mr,
+                                         std::function<size_t()> const& peak_footprint = {})
+{
+    auto const plan  = Inner_::make_replay_plan(events);
+    auto       slots = std::unique_ptr<std::atomic<void*>[]>{new std::atomic<void*>[plan.slots]{}};
+    auto       stats = replay_stats_t{};
+    auto       ready = std::atomic<size_t>{0};
+    auto       fails = std::atomic<size_t>{0};
+
+    auto replay = [&](std::vector<Inner_::replay_plan_t::step_t> const& steps) {
+        ready.fetch_add(1);
+        while (ready.load() != plan.threads.size()) {  // 全スレッドを同時に開始する
+            std::this_thread::yield();
+        }
+
+        for (auto const& [event, slot] : steps) {
+            auto& mem = slots[slot];
+
+            if (event->kind == alloc_kind::allocate) {
+                void* p = nullptr;
+                try {
+                    p = mr.allocate(event->size, event->alignment);
+                }
+                catch (std::bad_alloc const&) {
+                    fails.fetch_add(1, std::memory_order_relaxed);
+                    p = &mem;  // 失敗を示す番兵。解放はしない
+                }
+                mem.store(p, std::memory_order_release);
+                continue;
+            }
+
+            auto  backoff = 1U;
+            void* p       = nullptr;
+            while ((p = mem.exchange(nullptr, std::memory_order_acquire)) == nullptr) {  // 確保を待つ
+                Inner_::Backoff(backoff);
+            }
+
+            if (p != &mem) {
+                mr.deallocate(p, event->size, event->alignment);
+            }
+        }
+    };
+
+    auto const start = std::chrono::steady_clock::now();
+
+    if (plan.threads.size() == 1) {
+        replay(plan.threads.begin()->second);
+    }
+    else {
+        auto threads = std::vector<std::thread>{};
+        for (auto const& [thread, steps] : plan.threads) {
+            threads.emplace_back(replay, std::cref(steps));
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    stats.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                           .count();
+
+    stats.peak_footprint = peak_footprint ? peak_footprint() : 0;
+
+    for (auto const& [thread, steps] : plan.threads) {  // 解放されなかった領域の後始末
+        for (auto const& [event, slot] : steps) {
+            if (event->kind != alloc_kind::allocate) {
+                continue;
+            }
+
+            if (auto* p = slots[slot].exchange(nullptr); p != nullptr && p != &slots[slot]) {
+                mr.deallocate(p, event->size, event->alignment);
+            }
+        }
+    }
+
+    stats.threads         = plan.threads.size();
+    stats.failures        = fails.load();
+    stats.peak_live_bytes = plan.peak_live_bytes;
+    for (auto const& [thread, steps] : plan.threads) {
+        stats.events += steps.size();
+    }
+
+    return stats;
+}
+
+SUPPRESS_WARN_END;
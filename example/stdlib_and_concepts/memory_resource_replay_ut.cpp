@@ -0,0 +1,235 @@
+#include <malloc.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_gate.h"
+#include "memory_resource_replay.h"
+#include "memory_resource_tracing.h"
+#include "memory_resource_variable.h"
+#include "suppress_warning.h"
+
+namespace {
+
+alloc_event_t make_event(alloc_kind kind, uint32_t thread, uint64_t id, size_t size, size_t alignment = 8)
+{
+    return alloc_event_t{kind, thread, id, id, size, alignment};
+}
+
+TEST(NewDelete, memory_resource_replay)
+{
+    using k = alloc_kind;
+
+    // スレッド1は、スレッド0が確保した領域を解放する
+    auto const events = std::vector<alloc_event_t>{
+        make_event(k::allocate, 0, 0, 100),    make_event(k::allocate, 1, 1, 200),
+        make_event(k::deallocate, 1, 0, 100),  make_event(k::allocate, 0, 2, 300, 64),
+        make_event(k::deallocate, 0, 1, 200),  make_event(k::deallocate, 0, 99, 1),  // 対応する確保がない
+        make_event(k::allocate, 1, 3, 50),  // 解放されない
+    };
+
+    memory_resource_variable<4096> mrv;
+    auto const                     count = mrv.get_count();
+
+    auto const stats = replay_alloc_trace(events, mrv, [&] { return count - mrv.get_count_min(); });
+    std::cout << stats << std::endl;
+
+    ASSERT_EQ(6, stats.events);
+    ASSERT_EQ(2, stats.threads);
+    ASSERT_EQ(0, stats.failures);
+    ASSERT_EQ(500, stats.peak_live_bytes);
+    ASSERT_LE(stats.peak_live_bytes, stats.peak_footprint);
+    ASSERT_LT(0.0, stats.fragmentation());  // ヘッダと切り上げの分
+    ASSERT_EQ(count, mrv.get_count());      // 解放されなかった領域も後始末される
+}
+
+TEST(NewDelete, memory_resource_replay_failure)
+{
+    using k = alloc_kind;
+
+    auto const events = std::vector<alloc_event_t>{
+        make_event(k::allocate, 0, 0, 3000), make_event(k::allocate, 0, 1, 3000),  // 2つ目は確保できない
+        make_event(k::deallocate, 0, 1, 3000), make_event(k::deallocate, 0, 0, 3000)};
+
+    memory_resource_variable<4096> mrv;
+    auto const                     count = mrv.get_count();
+
+    auto const stats = replay_alloc_trace(events, mrv);
+
+    ASSERT_EQ(1, stats.failures);
+    ASSERT_EQ(0, stats.peak_footprint);
+    ASSERT_EQ(count, mrv.get_count());
+}
+
+/// @brief new_delete_resourceのフットプリントを、mallocが実際に割り当てたチャンクのサイズで近似する
+class malloc_usage_resource final : public std::pmr::memory_resource {
+public:
+    size_t get_peak() const noexcept { return peak_.load(); }
+
+private:
+    std::atomic<size_t> usage_{0};
+    std::atomic<size_t> peak_{0};
+
+    static size_t chunk_size(void* mem) noexcept { return ::malloc_usable_size(mem) + sizeof(size_t); }
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        auto* mem   = std::pmr::new_delete_resource()->allocate(size, alignment);
+        auto  usage = usage_.fetch_add(chunk_size(mem)) + chunk_size(mem);
+
+        for (auto peak = peak_.load(); peak < usage && !peak_.compare_exchange_weak(peak, usage);) {
+        }
+
+        return mem;
+    }
+
+    void do_deallocate(void* mem, size_t size, size_t alignment) override
+    {
+        usage_.fetch_sub(chunk_size(mem));
+        std::pmr::new_delete_resource()->deallocate(mem, size, alignment);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+/// @brief リクエスト処理を模したワークロードを、memory_resource_tracingで記録する
+/// @details 各スレッドは寿命の短い小さなオブジェクトを確保し、時々、大きなバッファを確保して隣のスレッドに渡す。
+///          渡されたバッファは受け取ったスレッドで解放する
+std::vector<alloc_event_t> record_synthetic_trace()
+{
+    constexpr auto threads    = 2U;
+    constexpr auto large_size = size_t{4096};
+
+    memory_resource_tracing<> mrt;
+    auto                      handoff = std::vector<std::atomic<void*>>(threads);
+
+    auto worker = [&](uint32_t index) {
+        auto rng   = std::mt19937{index};
+        auto sizes = std::uniform_int_distribution<size_t>{8, 256};
+        auto live  = std::vector<std::pair<void*, size_t>>(256, {nullptr, 0});
+
+        for (auto i = 0U; i < 20'000; ++i) {
+            auto& [p, size] = live[rng() % live.size()];
+            if (p != nullptr) {
+                mrt.deallocate(p, size);
+            }
+
+            size = sizes(rng);
+            p    = mrt.allocate(size);
+
+            if (i % 16 == 0) {
+                auto* const buffer = mrt.allocate(large_size);
+                if (auto* mine = handoff[(index + 1) % threads].exchange(buffer); mine != nullptr) {
+                    mrt.deallocate(mine, large_size);  // 隣のスレッドが受け取らなかったバッファ
+                }
+                if (auto* other = handoff[index].exchange(nullptr); other != nullptr) {
+                    mrt.deallocate(other, large_size);  // 隣のスレッドが確保したバッファ
+                }
+            }
+        }
+
+        for (auto& [p, size] : live) {
+            if (p != nullptr) {
+                mrt.deallocate(p, size);
+            }
+        }
+    };
+
+    auto ts = std::vector<std::thread>{};
+    for (auto i = 0U; i < threads; ++i) {
+        ts.emplace_back(worker, i);
+    }
+    for (auto& t : ts) {
+        t.join();
+    }
+
+    for (auto& h : handoff) {
+        if (auto* p = h.exchange(nullptr); p != nullptr) {
+            mrt.deallocate(p, large_size);
+        }
+    }
+
+    return mrt.get_events();
+}
+
+/// @brief 環境変数ALLOC_TRACEで指定したトレース(memory_resource_tracing::write_traceの出力)を読み込む。
+///        指定がなければ合成したワークロードのトレースを使う
+std::vector<alloc_event_t> load_trace()
+{
+    if (auto const* file = std::getenv("ALLOC_TRACE"); file != nullptr) {
+        auto ifs = std::ifstream{file, std::ios::binary};
+        return read_alloc_trace(ifs);
+    }
+
+    return record_synthetic_trace();
+}
+
+void measure_replay(std::vector<alloc_event_t> const& events, std::string const& name,
+                    std::function<replay_stats_t(std::vector<alloc_event_t> const&)> const& replay)
+{
+    constexpr auto repeat = 5;
+
+    auto samples_ns = std::vector<double>{};
+    auto stats      = replay_stats_t{};
+
+    for (auto i = 0; i < repeat; ++i) {
+        stats = replay(events);
+        samples_ns.push_back(static_cast<double>(stats.elapsed_ns) / stats.events);
+    }
+
+    RecordBenchmark("replay/" + name, CalcPerformanceStats(samples_ns, stats.events));
+    std::cout << name << " : " << stats << std::endl;
+
+    ASSERT_EQ(0, stats.failures);
+}
+
+TEST(Benchmark, memory_resource_replay)
+{
+    auto const events = load_trace();
+
+    measure_replay(events, "memory_resource_variable", [](auto const& trace) {
+        auto       mrv   = std::make_unique<memory_resource_variable<16 << 20>>();
+        auto const count = mrv->get_count();
+
+        return replay_alloc_trace(trace, *mrv, [&] { return count - mrv->get_count_min(); });
+    });
+
+    measure_replay(events, "unsynchronized_pool_resource", [](auto const& trace) {
+        auto upstream = memory_resource_tracing<>{std::pmr::new_delete_resource(), false};
+        auto pool     = std::pmr::unsynchronized_pool_resource{&upstream};
+
+        // トレースが複数スレッドの場合、スレッドセーフでないため直列化する
+        auto serial = trace;
+        for (auto& e : serial) {
+            e.thread = 0;
+        }
+
+        return replay_alloc_trace(serial, pool, [&] { return upstream.get_stats().peak_bytes; });
+    });
+
+    measure_replay(events, "synchronized_pool_resource", [](auto const& trace) {
+        auto upstream = memory_resource_tracing<>{std::pmr::new_delete_resource(), false};
+        auto pool     = std::pmr::synchronized_pool_resource{&upstream};
+
+        return replay_alloc_trace(trace, pool, [&] { return upstream.get_stats().peak_bytes; });
+    });
+
+    measure_replay(events, "new_delete_resource", [](auto const& trace) {
+        auto mr = malloc_usage_resource{};
+
+        return replay_alloc_trace(trace, mr, [&] { return mr.get_peak(); });
+    });
+}
+}  // namespace
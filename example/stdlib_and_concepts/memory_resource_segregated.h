@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+
+#include "memory_resource_variable.h"
+#include "spin_lock.h"
+#include "utils.h"
+
+/// @brief memory_resource_variableの前段に、サイズクラス毎のフリーリストを置いたメモリリソース(segregated fit)
+/// @details max_bin_units個以下のheader_tから成るブロックは、解放時にそのサイズのビンに戻し、
+///          同じサイズの確保ではリストを探索せずにビンから返す(O(1))。
+///          それ以外のサイズ、およびビンが空の場合はmemory_resource_variableのfirst-fitで確保する。
+///          first-fitでの確保に失敗した場合は、ビン内のブロックをmemory_resource_variableに返して
+///          隣接する空き領域と連結(Inner_::concat)した後、再試行する。
+///          ビン内のブロックは空き領域としてget_count()に含まれる。
+template <uint32_t MEM_SIZE, typename LOCK = SpinLock>
+class memory_resource_segregated final : public std::pmr::memory_resource {
+public:
+    static constexpr size_t max_bin_units = 64;  // ビンで管理するブロックの最大サイズ(header_tの個数)
+
+    memory_resource_segregated() = default;
+
+    memory_resource_segregated(memory_resource_segregated const&)            = delete;
+    memory_resource_segregated& operator=(memory_resource_segregated const&) = delete;
+
+    size_t get_count() const noexcept
+    {
+        auto lock = std::lock_guard{lock_};
+        return arena_.get_count() + binned_units_ * Inner_::unit_size;
+    }
+
+    bool is_valid(void const* mem) const noexcept { return arena_.is_valid(mem); }
+
+    /// @brief ビン内のブロックをすべてmemory_resource_variableに返し、隣接する空き領域と連結する
+    void coalesce() noexcept
+    {
+        auto lock = std::lock_guard{lock_};
+        flush();
+    }
+
+private:
+    using header_t = Inner_::header_t;
+
+    mutable LOCK                                 lock_{};
+    memory_resource_variable<MEM_SIZE, NullLock> arena_{};                   // 排他制御はlock_で行う
+    header_t*                                    bins_[max_bin_units + 1]{};  // bins_[n]はn個のheader_tから成るブロック
+    size_t                                       binned_units_{0};
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        auto const n_units = (Roundup(Inner_::unit_size, size) / Inner_::unit_size) + 1;
+
+        auto lock = std::lock_guard{lock_};
+
+        // first-fitは要求より1つ大きいブロックを返すことがあるため、そのビンも探す
+        // ビン内のブロックはmax_align_tにしか整列していないため、それを超えるアライメントはfirst-fitで確保する
+        for (auto n = n_units; alignment <= Inner_::unit_size && n <= std::min(n_units + 1, max_bin_units); ++n) {
+            if (auto* header = bins_[n]; header != nullptr) {
+                bins_[n] = header->next;
+                binned_units_ -= n;
+                return header + 1;
+            }
+        }
+
+        try {
+            return arena_.allocate(size, alignment);
+        }
+        catch (std::bad_alloc const&) {
+            if (binned_units_ == 0) {
+                throw;
+            }
+        }
+
+        flush();
+        return arena_.allocate(size, alignment);
+    }
+
+    void do_deallocate(void* mem, size_t size, size_t alignment) noexcept override
+    {
+        auto* header = Inner_::set_back(mem);
+
+        auto lock = std::lock_guard{lock_};
+
+        if (auto const n = header->n_units; n <= max_bin_units) {
+            header->next = bins_[n];
+            bins_[n]     = header;
+            binned_units_ += n;
+            return;
+        }
+
+        arena_.deallocate(mem, size, alignment);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+
+    void flush() noexcept
+    {
+        for (auto& bin : bins_) {
+            while (bin != nullptr) {
+                auto* header = bin;
+                bin          = header->next;
+                arena_.deallocate(header + 1, (header->n_units - 1) * Inner_::unit_size);
+            }
+        }
+
+        binned_units_ = 0;
+    }
+};
@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_gate.h"
+#include "measure_performance.h"
+#include "memory_resource_segregated.h"
+#include "memory_resource_variable.h"
+#include "suppress_warning.h"
+
+namespace {
+
+using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+
+TEST(NewDelete, memory_resource_segregated)
+{
+    memory_resource_segregated<1024> mrs;
+    auto const                       count = mrs.get_count();
+
+    {
+        pmr_string str{"segregated free list memory resource", &mrs};
+        ASSERT_TRUE(mrs.is_valid(str.c_str()));
+        ASSERT_GT(count, mrs.get_count());
+
+        auto str3 = str + str + str;
+        ASSERT_EQ(str.size() * 3, str3.size());
+        ASSERT_THROW(str3 = pmr_string(2000, 'a', &mrs), std::bad_alloc);
+    }
+
+    ASSERT_EQ(count, mrs.get_count());  // ビン内のブロックも空き領域として数える
+}
+
+TEST(NewDelete, memory_resource_segregated_bin)
+{
+    memory_resource_segregated<1024> mrs;
+
+    void* p0 = mrs.allocate(32);
+    mrs.deallocate(p0, 32);
+
+    void* p1 = mrs.allocate(32);  // 同じサイズはビンから返す
+    ASSERT_EQ(p0, p1);
+    mrs.deallocate(p1, 32);
+}
+
+TEST(NewDelete, memory_resource_segregated_coalesce)
+{
+    memory_resource_segregated<1024> mrs;
+    auto const                       count = mrs.get_count();
+
+    auto ps = std::vector<void*>{};
+    ps.reserve(100);
+
+    try {
+        for (;;) {
+            ps.push_back(mrs.allocate(16));
+        }
+    }
+    catch (std::bad_alloc const&) {
+    }
+
+    for (auto* p : ps) {
+        mrs.deallocate(p, 16);  // すべてビンに戻る
+    }
+    ASSERT_EQ(count, mrs.get_count());
+
+    // ビンのブロックを連結しなければ確保できないサイズ
+    void* p = mrs.allocate(count / 2);
+    ASSERT_TRUE(mrs.is_valid(p));
+    mrs.deallocate(p, count / 2);
+
+    mrs.coalesce();
+    ASSERT_EQ(count, mrs.get_count());
+}
+
+/// @brief サイズの異なる確保と解放をランダムに繰り返し、フラグメンテーションを起こしながら計測する
+template <typename MR>
+PerformanceStats measure_churn(char const* name)
+{
+    MR   mr;
+    auto rng   = std::mt19937{1};
+    auto sizes = std::uniform_int_distribution<size_t>{8, 256};
+    auto slots = std::uniform_int_distribution<size_t>{0, 255};
+
+    auto live = std::vector<std::pair<void*, size_t>>(256, {nullptr, 0});
+
+    auto options    = MeasureOptions{};
+    options.warmup  = 1000;
+    options.samples = 20;
+
+    auto stats = RecordBenchmark(name, MeasurePerformanceStats(options, [&] {
+                                     auto& [p, size] = live[slots(rng)];
+                                     if (p != nullptr) {
+                                         mr.deallocate(p, size);
+                                     }
+
+                                     size = sizes(rng);
+                                     p    = mr.allocate(size);
+                                 }));
+
+    for (auto& [p, size] : live) {
+        if (p != nullptr) {
+            mr.deallocate(p, size);
+        }
+    }
+
+    return stats;
+}
+
+TEST(Benchmark, memory_resource_segregated)
+{
+    constexpr uint32_t mem_size = 128 * 1024;
+
+    auto const first_fit  = measure_churn<memory_resource_variable<mem_size>>("mixed_churn/memory_resource_variable");
+    auto const segregated = measure_churn<memory_resource_segregated<mem_size>>("mixed_churn/memory_resource_segregated");
+
+    std::cout << "memory_resource_variable   : " << first_fit << std::endl;
+    std::cout << "memory_resource_segregated : " << segregated << std::endl;
+}
+}  // namespace
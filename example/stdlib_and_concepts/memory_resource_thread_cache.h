@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+
+#include "memory_resource_variable.h"
+#include "spin_lock.h"
+#include "utils.h"
+
+/// @brief memory_resource_variableの前段に、スレッド毎のマガジン(サイズクラス毎の解放済みブロックのスタック)を置いたメモリリソース
+/// @details max_class_units個以下のheader_tから成るブロックの確保/解放は、通常はスレッドのマガジンのみで完結し、
+///          共有のロック(LOCK)を取らない。マガジンが空または満杯になった場合のみ、共有のロックを取り、
+///          batch_size個のブロックをまとめて共有のデポ(サイズクラス毎のフリーリスト)またはアリーナとやり取りする。
+///          マガジンはスレッド番号 % slot_countのスロットに置かれ、スロット毎のSpinLockで保護されるが、
+///          スレッド数がslot_count以下であれば、このロックは競合せずキャッシュラインも共有されない。
+///          アリーナからの確保に失敗した場合は、デポと全スロットのマガジンのブロックをアリーナに返して連結した後、
+///          再試行する。
+template <uint32_t MEM_SIZE, typename LOCK = SpinLock>
+class memory_resource_thread_cache final : public std::pmr::memory_resource {
+public:
+    static constexpr size_t max_class_units = 16;  // キャッシュするブロックの最大サイズ(header_tの個数)
+    static constexpr size_t magazine_size   = 16;
+    static constexpr size_t batch_size      = magazine_size / 2;
+    static constexpr size_t slot_count      = 16;
+
+    memory_resource_thread_cache() = default;
+
+    memory_resource_thread_cache(memory_resource_thread_cache const&)            = delete;
+    memory_resource_thread_cache& operator=(memory_resource_thread_cache const&) = delete;
+
+    /// @brief 空き領域のバイト数。マガジン、デポ内のブロックも空き領域に含む
+    size_t get_count() const noexcept
+    {
+        auto units = size_t{0};
+
+        for (auto& slot : slots_) {
+            auto lock = std::lock_guard{slot.lock};
+            for (auto const& magazine : slot.magazines) {
+                for (auto i = 0U; i < magazine.count; ++i) {
+                    units += magazine.blocks[i]->n_units;
+                }
+            }
+        }
+
+        auto lock = std::lock_guard{lock_};
+        return arena_.get_count() + (units + depot_units_) * Inner_::unit_size;
+    }
+
+    bool is_valid(void const* mem) const noexcept { return arena_.is_valid(mem); }
+
+private:
+    using header_t = Inner_::header_t;
+
+    struct magazine_t {
+        header_t* blocks[magazine_size]{};
+        size_t    count{0};
+    };
+
+    struct alignas(cache_line_size) slot_t {
+        mutable SpinLock lock{};
+        magazine_t       magazines[max_class_units + 1]{};  // magazines[n]はn個のheader_tから成るブロック
+    };
+
+    slot_t                                       slots_[slot_count]{};
+    mutable LOCK                                 lock_{};   // 以下を保護する
+    memory_resource_variable<MEM_SIZE, NullLock> arena_{};  // 排他制御はlock_で行う
+    header_t*                                    depot_[max_class_units + 1]{};
+    size_t                                       depot_units_{0};
+
+    static size_t to_units(size_t size) noexcept { return (Roundup(Inner_::unit_size, size) / Inner_::unit_size) + 1; }
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        auto const n_units = to_units(size);
+
+        if (n_units > max_class_units || alignment > Inner_::unit_size) {  // マガジンのブロックは整列していない
+            auto lock = std::lock_guard{lock_};
+            return allocate_arena(size, alignment, nullptr);
+        }
+
+        auto& slot = slots_[Inner_::ThreadIndex() % slot_count];
+        auto  lock = std::lock_guard{slot.lock};
+
+        auto& magazine = slot.magazines[n_units];
+        if (magazine.count == 0) {
+            refill(slot, magazine, n_units, size, alignment);
+        }
+
+        return magazine.blocks[--magazine.count] + 1;
+    }
+
+    void do_deallocate(void* mem, size_t size, size_t alignment) noexcept override
+    {
+        auto* header  = Inner_::set_back(mem);
+        auto  n_units = header->n_units;  // first-fitは要求より1つ大きいブロックを返すことがある
+
+        if (n_units > max_class_units) {
+            auto lock = std::lock_guard{lock_};
+            arena_.deallocate(mem, size, alignment);
+            return;
+        }
+
+        auto& slot = slots_[Inner_::ThreadIndex() % slot_count];
+        auto  lock = std::lock_guard{slot.lock};
+
+        auto& magazine = slot.magazines[n_units];
+        if (magazine.count == magazine_size) {
+            drain(magazine, n_units);
+        }
+
+        magazine.blocks[magazine.count++] = header;
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+
+    /// @brief slotの空のマガジンに、デポまたはアリーナからbatch_size個までのブロックを補充する
+    /// @details slot.lockを取って呼び出す。
+    void refill(slot_t& slot, magazine_t& magazine, size_t n_units, size_t size, size_t alignment)
+    {
+        auto lock = std::lock_guard{lock_};
+
+        while (magazine.count < batch_size && depot_[n_units] != nullptr) {
+            auto* header                      = depot_[n_units];
+            depot_[n_units]                   = header->next;
+            magazine.blocks[magazine.count++] = header;
+            depot_units_ -= header->n_units;
+        }
+
+        try {
+            while (magazine.count < batch_size) {
+                magazine.blocks[magazine.count++] = Inner_::set_back(allocate_arena(size, alignment, &slot));
+            }
+        }
+        catch (std::bad_alloc const&) {
+            if (magazine.count == 0) {
+                throw;
+            }
+        }
+    }
+
+    /// @brief 満杯のマガジンからbatch_size個のブロックをデポに移す
+    void drain(magazine_t& magazine, size_t n_units) noexcept
+    {
+        auto lock = std::lock_guard{lock_};
+
+        for (auto i = 0U; i < batch_size; ++i) {
+            auto* header    = magazine.blocks[--magazine.count];
+            header->next    = depot_[n_units];
+            depot_[n_units] = header;
+            depot_units_ += header->n_units;
+        }
+    }
+
+    /// @brief アリーナから確保する。失敗した場合、デポと全スロットのマガジンのブロックをアリーナに返して再試行する
+    /// @param held 呼び出し元がロックを取っているスロット。なければnullptr
+    /// @details lock_を取って呼び出す。
+    ///          ロックの順序はslot_t::lock→lock_であるため、held以外のスロットはtry_lockでスロット順に取り、
+    ///          取れないスロット(所有スレッドがlock_を待っている等)は飛ばす。
+    void* allocate_arena(size_t size, size_t alignment, slot_t* held)
+    {
+        try {
+            return arena_.allocate(size, alignment);
+        }
+        catch (std::bad_alloc const&) {
+        }
+
+        for (auto& list : depot_) {
+            while (list != nullptr) {
+                auto* header = list;
+                list         = header->next;
+                release_arena(header);
+            }
+        }
+        depot_units_ = 0;
+
+        for (auto& slot : slots_) {
+            if (&slot == held) {
+                release_arena(slot);
+            }
+            else if (slot.lock.try_lock()) {
+                release_arena(slot);
+                slot.lock.unlock();
+            }
+        }
+
+        return arena_.allocate(size, alignment);
+    }
+
+    /// @brief slotの全マガジンのブロックをアリーナに返す。slot.lockとlock_を取って呼び出す
+    void release_arena(slot_t& slot) noexcept
+    {
+        for (auto& magazine : slot.magazines) {
+            while (magazine.count != 0) {
+                release_arena(magazine.blocks[--magazine.count]);
+            }
+        }
+    }
+
+    void release_arena(header_t* header) noexcept
+    {
+        arena_.deallocate(header + 1, (header->n_units - 1) * Inner_::unit_size);
+    }
+};
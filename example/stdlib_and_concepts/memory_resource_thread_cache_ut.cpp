@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "memory_resource_thread_cache.h"
+#include "memory_resource_variable.h"
+#include "suppress_warning.h"
+
+namespace {
+
+using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+
+TEST(NewDelete, memory_resource_thread_cache)
+{
+    auto       mrc   = std::make_unique<memory_resource_thread_cache<4096>>();
+    auto const count = mrc->get_count();
+
+    {
+        pmr_string str{"per-thread magazine cache", mrc.get()};
+        ASSERT_TRUE(mrc->is_valid(str.c_str()));
+        ASSERT_GT(count, mrc->get_count());
+
+        auto str3 = str + str + str;
+        ASSERT_EQ(str.size() * 3, str3.size());
+        ASSERT_THROW(str3 = pmr_string(5000, 'a', mrc.get()), std::bad_alloc);
+    }
+
+    ASSERT_EQ(count, mrc->get_count());  // マガジン、デポ内のブロックも空き領域として数える
+
+    void* p0 = mrc->allocate(32);
+    mrc->deallocate(p0, 32);
+    void* p1 = mrc->allocate(32);  // 直前に解放したブロックをマガジンから返す
+    ASSERT_EQ(p0, p1);
+    mrc->deallocate(p1, 32);
+}
+
+TEST(NewDelete, memory_resource_thread_cache_threads)
+{
+    auto       mrc   = std::make_unique<memory_resource_thread_cache<16 * 1024>>();
+    auto const count = mrc->get_count();
+
+    auto ps = std::vector<void*>(64);
+    for (auto& p : ps) {
+        p = mrc->allocate(48);
+    }
+
+    std::thread{[&] {
+        for (auto* p : ps) {  // 別スレッドで解放したブロックは、デポを経由して再利用される
+            mrc->deallocate(p, 48);
+        }
+    }}.join();
+
+    ASSERT_EQ(count, mrc->get_count());
+
+    auto const stats = MeasureContention(ContentionOptions{4, 10'000, false}, [&mrc] {
+        pmr_string str{"string longer than sso buffer", mrc.get()};
+        DoNotOptimize(str);
+    });
+    ASSERT_EQ(40'000, stats.total_ops);
+
+    ASSERT_EQ(count, mrc->get_count());
+}
+
+TEST(NewDelete, memory_resource_thread_cache_exhaustion)
+{
+    auto       mrc   = std::make_unique<memory_resource_thread_cache<4096>>();
+    auto const count = mrc->get_count();
+
+    auto ps = std::vector<void*>{};
+    ps.reserve(count);
+
+    try {
+        for (;;) {
+            ps.push_back(mrc->allocate(16));
+        }
+    }
+    catch (std::bad_alloc const&) {
+    }
+
+    for (auto* p : ps) {
+        mrc->deallocate(p, 16);  // magazine_size個以外はデポに移る
+    }
+    ASSERT_EQ(count, mrc->get_count());
+
+    // デポのブロックをアリーナに返して連結しなければ確保できないサイズ
+    void* p = mrc->allocate(count / 2);
+    ASSERT_TRUE(mrc->is_valid(p));
+    mrc->deallocate(p, count / 2);
+}
+
+TEST(NewDelete, memory_resource_thread_cache_exhaustion_threads)
+{
+    using mr_t = memory_resource_thread_cache<4096>;
+
+    auto       mrc   = std::make_unique<mr_t>();
+    auto const count = mrc->get_count();
+    auto const slot  = Inner_::ThreadIndex() % mr_t::slot_count;
+
+    // このスレッドと異なるスロットを使うスレッドで確保/解放し、そのマガジンにブロックを残す
+    for (auto filled = false; !filled;) {
+        std::thread{[&] {
+            if (Inner_::ThreadIndex() % mr_t::slot_count == slot) {
+                return;
+            }
+
+            auto ps = std::vector<void*>(mr_t::magazine_size);
+            for (auto& p : ps) {
+                p = mrc->allocate(200);
+            }
+            for (auto* p : ps) {
+                mrc->deallocate(p, 200);  // マガジンが満杯にならないため、デポには移らない
+            }
+            filled = true;
+        }}.join();
+    }
+    ASSERT_EQ(count, mrc->get_count());
+
+    // 他のスロットのマガジンのブロックをアリーナに返して連結しなければ確保できないサイズ
+    void* p = mrc->allocate(count / 2);
+    ASSERT_TRUE(mrc->is_valid(p));
+    mrc->deallocate(p, count / 2);
+
+    ASSERT_EQ(count, mrc->get_count());
+}
+
+template <typename MR>
+void measure_thread_scaling(MR& mr, char const* name)
+{
+    for (auto const& stats : SweepContention(
+             50'000,
+             [&mr] {
+                 void* p = mr.allocate(64);
+                 DoNotOptimize(p);
+                 mr.deallocate(p, 64);
+             },
+             std::max(4U, HardwareThreads()))) {
+        std::cout << name << stats << std::endl;
+    }
+}
+
+TEST(Benchmark, memory_resource_thread_cache)
+{
+    auto mrv  = std::make_unique<memory_resource_variable<64 * 1024>>();
+    auto mrc  = std::make_unique<memory_resource_thread_cache<64 * 1024>>();
+    auto pool = std::pmr::synchronized_pool_resource{};
+
+    measure_thread_scaling(*mrv, "memory_resource_variable     ");
+    measure_thread_scaling(*mrc, "memory_resource_thread_cache ");
+    measure_thread_scaling(pool, "synchronized_pool_resource   ");
+}
+}  // namespace
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "memory_resource_variable.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+namespace Inner_ {
+
+/// @brief TLSFのブロックのヘッダ。next_free/prev_freeは空きブロックの場合のみ有効で、使用中はユーザ領域になる
+struct tlsf_block_t {
+    tlsf_block_t* prev_phys;  // 物理的に直前のブロック(tlsf_prev_freeの場合のみ参照する)
+    size_t        size;       // ヘッダを含むブロックのサイズ。下位ビットはフラグ
+    tlsf_block_t* next_free;
+    tlsf_block_t* prev_free;
+};
+
+constexpr size_t tlsf_align       = alignof(std::max_align_t);
+constexpr size_t tlsf_header_size = offsetof(tlsf_block_t, next_free);  // 使用中ブロックのオーバーヘッド
+constexpr size_t tlsf_min_block   = sizeof(tlsf_block_t);
+constexpr size_t tlsf_free        = 1;  // sizeのフラグ: このブロックは空き
+constexpr size_t tlsf_prev_free   = 2;  // sizeのフラグ: 物理的に直前のブロックは空き
+constexpr size_t tlsf_flags       = tlsf_free | tlsf_prev_free;
+
+constexpr uint32_t tlsf_sl_shift    = 4;  // 第2レベルの分割数のlog2
+constexpr uint32_t tlsf_sl_count    = 1U << tlsf_sl_shift;
+constexpr uint32_t tlsf_align_shift = 4;  // log2(tlsf_align)
+constexpr uint32_t tlsf_fl_shift    = tlsf_sl_shift + tlsf_align_shift;
+constexpr size_t   tlsf_small_block = size_t{1} << tlsf_fl_shift;  // これより小さいブロックは第1レベルが0
+constexpr uint32_t tlsf_fl_count    = 32;
+
+/// @brief tlsf_heap_tが管理できるメモリ領域のサイズの上限。これ以上のブロックの第1レベルはtlsf_fl_countを超える
+constexpr size_t tlsf_max_heap_size = size_t{1} << (tlsf_fl_count - 1 + tlsf_fl_shift);
+
+static_assert(tlsf_header_size == tlsf_align && (size_t{1} << tlsf_align_shift) == tlsf_align);
+
+inline size_t tlsf_size(tlsf_block_t const* block) noexcept { return block->size & ~tlsf_flags; }
+
+inline tlsf_block_t* tlsf_next_phys(tlsf_block_t* block) noexcept
+{
+    return reinterpret_cast<tlsf_block_t*>(reinterpret_cast<uint8_t*>(block) + tlsf_size(block));
+}
+
+inline uint32_t tlsf_msb(size_t v) noexcept { return 63 - __builtin_clzll(v); }
+
+/// @brief ブロックサイズが属するフリーリストの(第1レベル, 第2レベル)
+inline std::pair<uint32_t, uint32_t> tlsf_mapping_insert(size_t size) noexcept
+{
+    if (size < tlsf_small_block) {
+        return {0, static_cast<uint32_t>(size >> tlsf_align_shift)};
+    }
+
+    auto const msb = tlsf_msb(size);
+    auto const sl  = static_cast<uint32_t>(size >> (msb - tlsf_sl_shift)) ^ tlsf_sl_count;
+
+    return {msb - tlsf_fl_shift + 1, sl};
+}
+
+/// @brief sizeを必ず満たすブロックのみを持つフリーリストの(第1レベル, 第2レベル)
+inline std::pair<uint32_t, uint32_t> tlsf_mapping_search(size_t size) noexcept
+{
+    if (size >= tlsf_small_block) {
+        size += (size_t{1} << (tlsf_msb(size) - tlsf_sl_shift)) - 1;  // 次のクラスに切り上げる
+    }
+
+    return tlsf_mapping_insert(size);
+}
+}  // namespace Inner_
+
+/// @brief memory_resource_tlsfのフラグメンテーションの統計
+struct tlsf_stats_t {
+    size_t free_bytes{0};          ///< 空き領域の合計(ヘッダを含む)
+    size_t used_bytes{0};          ///< 使用中の領域の合計(ヘッダを含む)
+    size_t free_blocks{0};         ///< 空きブロック数
+    size_t used_blocks{0};         ///< 使用中のブロック数
+    size_t largest_free_block{0};  ///< 最大の空きブロック
+
+    /// @brief 1 - 最大の空きブロック / 空き領域の合計。0ならば空き領域は1つにまとまっている
+    double fragmentation() const noexcept
+    {
+        return free_bytes == 0 ? 0.0 : 1.0 - static_cast<double>(largest_free_block) / free_bytes;
+    }
+};
+
+namespace Inner_ {
+
+/// @brief 与えられたメモリ領域をTLSF(Two-Level Segregated Fit)アルゴリズムで管理するヒープ。排他制御は呼び出し側で行う
+/// @details 空きブロックをサイズの第1レベル(2のべき乗)と第2レベル(その16分割)で分類したフリーリストで管理し、
+///          ビットマップの検索によりallocate/deallocateとも最悪実行時間がO(1)となる。
+///          解放時には、境界タグにより物理的に隣接する空きブロックと即座に連結する。
+class tlsf_heap_t {
+public:
+    /// @param mem tlsf_alignに整列したメモリ領域
+    /// @param size memのバイト数。tlsf_max_heap_size以下
+    tlsf_heap_t(void* mem, size_t size) noexcept : base_{static_cast<uint8_t*>(mem)}
+    {
+        size &= ~(tlsf_align - 1);
+        assert(reinterpret_cast<uintptr_t>(mem) % tlsf_align == 0);
+        assert(size >= tlsf_min_block + tlsf_header_size);
+        assert(size <= tlsf_max_heap_size);
+
+        // 末尾は連結を止めるための番兵(サイズ0の使用中ブロック)
+        auto const first_size = size - tlsf_header_size;
+
+        auto* first      = reinterpret_cast<tlsf_block_t*>(base_);
+        first->prev_phys = nullptr;
+        first->size      = first_size | tlsf_free;
+
+        auto* sentinel      = tlsf_next_phys(first);
+        sentinel->prev_phys = first;
+        sentinel->size      = tlsf_prev_free;
+
+        free_bytes_ = first_size;
+        insert_free(first);
+    }
+
+    tlsf_heap_t(tlsf_heap_t const&)            = delete;
+    tlsf_heap_t& operator=(tlsf_heap_t const&) = delete;
+
+    /// @brief 確保できない場合、nullptrを返す
+    void* allocate(size_t size) noexcept
+    {
+        // block_sizeの切り上げでラップアラウンドする
+        if (size > std::numeric_limits<size_t>::max() - tlsf_header_size - tlsf_align) {
+            return nullptr;
+        }
+
+        auto const block_size
+            = std::max((size + tlsf_header_size + tlsf_align - 1) & ~(tlsf_align - 1), tlsf_min_block);
+
+        auto* block = find_free(block_size);
+        if (block == nullptr) {
+            return nullptr;
+        }
+
+        remove_free(block);
+        split(block, block_size);
+
+        block->size &= ~tlsf_free;
+        free_bytes_ -= tlsf_size(block);
+
+        return reinterpret_cast<uint8_t*>(block) + tlsf_header_size;
+    }
+
+    void deallocate(void* mem) noexcept
+    {
+        auto* block = reinterpret_cast<tlsf_block_t*>(static_cast<uint8_t*>(mem) - tlsf_header_size);
+
+        free_bytes_ += tlsf_size(block);
+        block->size |= tlsf_free;
+
+        if (block->size & tlsf_prev_free) {  // 直前の空きブロックと連結
+            auto* prev = block->prev_phys;
+            remove_free(prev);
+            prev->size += tlsf_size(block);
+            block = prev;
+        }
+
+        auto* next = tlsf_next_phys(block);
+        if (next->size & tlsf_free) {  // 直後の空きブロックと連結
+            remove_free(next);
+            block->size += tlsf_size(next);
+            next = tlsf_next_phys(block);
+        }
+
+        next->prev_phys = block;
+        next->size |= tlsf_prev_free;
+
+        insert_free(block);
+    }
+
+    size_t get_count() const noexcept { return free_bytes_; }
+
+    /// @brief 全ブロックを物理アドレス順にfunc(ブロック, サイズ, 空きならtrue)で走査する
+    template <typename FUNC>
+    void for_each_block(FUNC&& func) const
+    {
+        for (auto* block = reinterpret_cast<tlsf_block_t*>(base_); tlsf_size(block) != 0;
+             block       = tlsf_next_phys(block)) {
+            func(block, tlsf_size(block), (block->size & tlsf_free) != 0);
+        }
+    }
+
+    /// @brief 全ブロックを走査して統計を求める。O(ブロック数)のため、リアルタイム処理中には呼び出さない
+    tlsf_stats_t get_stats() const noexcept
+    {
+        auto stats = tlsf_stats_t{};
+
+        for_each_block([&stats](tlsf_block_t const*, size_t size, bool is_free) {
+            if (is_free) {
+                stats.free_bytes += size;
+                ++stats.free_blocks;
+                stats.largest_free_block = std::max(stats.largest_free_block, size);
+            }
+            else {
+                stats.used_bytes += size;
+                ++stats.used_blocks;
+            }
+        });
+
+        return stats;
+    }
+
+private:
+    uint8_t* const base_;
+    size_t         free_bytes_{0};
+    uint32_t       fl_bitmap_{0};
+    uint32_t       sl_bitmap_[tlsf_fl_count]{};
+    tlsf_block_t*  free_lists_[tlsf_fl_count][tlsf_sl_count]{};
+
+    tlsf_block_t* find_free(size_t size) const noexcept
+    {
+        auto [fl, sl] = tlsf_mapping_search(size);
+        if (fl >= tlsf_fl_count) {
+            return nullptr;
+        }
+
+        auto sl_map = sl_bitmap_[fl] & (~0U << sl);
+        if (sl_map == 0) {  // 同じ第1レベルになければ、より大きい第1レベルを探す
+            auto const fl_map = fl + 1 < tlsf_fl_count ? fl_bitmap_ & (~0U << (fl + 1)) : 0U;
+            if (fl_map == 0) {
+                return nullptr;
+            }
+
+            fl     = __builtin_ctz(fl_map);
+            sl_map = sl_bitmap_[fl];
+        }
+
+        return free_lists_[fl][__builtin_ctz(sl_map)];
+    }
+
+    void insert_free(tlsf_block_t* block) noexcept
+    {
+        auto const [fl, sl] = tlsf_mapping_insert(tlsf_size(block));
+
+        block->prev_free = nullptr;
+        block->next_free = free_lists_[fl][sl];
+        if (block->next_free != nullptr) {
+            block->next_free->prev_free = block;
+        }
+
+        free_lists_[fl][sl] = block;
+        fl_bitmap_ |= 1U << fl;
+        sl_bitmap_[fl] |= 1U << sl;
+    }
+
+    void remove_free(tlsf_block_t* block) noexcept
+    {
+        auto const [fl, sl] = tlsf_mapping_insert(tlsf_size(block));
+
+        if (block->next_free != nullptr) {
+            block->next_free->prev_free = block->prev_free;
+        }
+
+        if (block->prev_free != nullptr) {
+            block->prev_free->next_free = block->next_free;
+            return;
+        }
+
+        free_lists_[fl][sl] = block->next_free;
+        if (block->next_free == nullptr) {
+            sl_bitmap_[fl] &= ~(1U << sl);
+            if (sl_bitmap_[fl] == 0) {
+                fl_bitmap_ &= ~(1U << fl);
+            }
+        }
+    }
+
+    /// @brief blockの先頭sizeバイトを残し、残りが最小ブロック以上であれば空きブロックとして切り出す
+    void split(tlsf_block_t* block, size_t size) noexcept
+    {
+        auto const remain = tlsf_size(block) - size;
+
+        if (remain < tlsf_min_block) {
+            tlsf_next_phys(block)->size &= ~tlsf_prev_free;
+            return;
+        }
+
+        block->size = size | (block->size & tlsf_flags);
+
+        auto* rest      = tlsf_next_phys(block);
+        rest->prev_phys = block;
+        rest->size      = remain | tlsf_free;  // blockは使用中になるため、tlsf_prev_freeは立てない
+
+        auto* next      = tlsf_next_phys(rest);
+        next->prev_phys = rest;
+        next->size |= tlsf_prev_free;
+
+        insert_free(rest);
+    }
+};
+}  // namespace Inner_
+
+/// @brief TLSFアルゴリズム(Inner_::tlsf_heap_t)による、固定長バッファ上のメモリリソース
+/// @details allocate/deallocateとも最悪実行時間がO(1)となるため、リアルタイム処理に適する。
+///          max_align_tを超えるアライメントの要求はstd::bad_allocとなる。
+template <uint32_t MEM_SIZE, typename LOCK = SpinLock>
+class memory_resource_tlsf final : public std::pmr::memory_resource {
+public:
+    memory_resource_tlsf() noexcept = default;
+
+    memory_resource_tlsf(memory_resource_tlsf const&)            = delete;
+    memory_resource_tlsf& operator=(memory_resource_tlsf const&) = delete;
+
+    size_t get_count() const noexcept { return heap_.get_count(); }
+    bool   is_valid(void const* mem) const noexcept
+    {
+        return (&buff_ < mem) && (mem < &buff_.buffer[ArrayLength(buff_.buffer)]);
+    }
+
+    tlsf_stats_t get_stats() const noexcept
+    {
+        auto lock = std::lock_guard{lock_};
+        return heap_.get_stats();
+    }
+
+private:
+    Inner_::buffer_t<MEM_SIZE> buff_{};
+    mutable LOCK               lock_{};
+    Inner_::tlsf_heap_t        heap_{buff_.buffer, sizeof(buff_.buffer)};
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        if (alignment > Inner_::tlsf_align) {
+            throw std::bad_alloc{};
+        }
+
+        auto lock = std::lock_guard{lock_};
+
+        if (auto* mem = heap_.allocate(size); mem != nullptr) {
+            return mem;
+        }
+
+        throw std::bad_alloc{};
+    }
+
+    void do_deallocate(void* mem, size_t, size_t) noexcept override
+    {
+        auto lock = std::lock_guard{lock_};
+        heap_.deallocate(mem);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+SUPPRESS_WARN_END;
@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_gate.h"
+#include "measure_performance.h"
+#include "memory_resource_tlsf.h"
+#include "memory_resource_variable.h"
+#include "suppress_warning.h"
+
+namespace {
+
+using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+
+TEST(NewDelete, memory_resource_tlsf)
+{
+    memory_resource_tlsf<1024> mrt;
+    auto const                 count = mrt.get_count();
+
+    {
+        pmr_string str{"two-level segregated fit memory resource", &mrt};
+        ASSERT_TRUE(mrt.is_valid(str.c_str()));
+        ASSERT_GT(count, mrt.get_count());
+
+        auto str3 = str + str + str;
+        ASSERT_EQ(str.size() * 3, str3.size());
+        ASSERT_THROW(str3 = pmr_string(2000, 'a', &mrt), std::bad_alloc);
+    }
+
+    ASSERT_EQ(count, mrt.get_count());
+
+    auto const stats = mrt.get_stats();
+    ASSERT_EQ(1, stats.free_blocks);  // 解放時に即座に連結される
+    ASSERT_EQ(0, stats.used_blocks);
+    ASSERT_EQ(count, stats.largest_free_block);
+    ASSERT_DOUBLE_EQ(0.0, stats.fragmentation());
+
+    ASSERT_THROW(DoNotOptimize(mrt.allocate(16, 64)), std::bad_alloc);  // max_align_tを超えるアライメントは未対応
+
+    // ブロックサイズの計算でラップアラウンドし、小さなブロックが返されてはならない
+    // 定数のままでは-Walloc-size-larger-thanとなるため、DoNotOptimizeで実行時の値にする
+    for (auto huge : {SIZE_MAX, SIZE_MAX - Inner_::tlsf_header_size}) {
+        DoNotOptimize(huge);
+        ASSERT_THROW(DoNotOptimize(mrt.allocate(huge)), std::bad_alloc);
+    }
+    ASSERT_EQ(count, mrt.get_count());
+}
+
+TEST(NewDelete, memory_resource_tlsf_fragmentation)
+{
+    memory_resource_tlsf<4096> mrt;
+
+    auto ps = std::vector<void*>{};
+    for (auto i = 0; i < 16; ++i) {
+        ps.push_back(mrt.allocate(48));
+    }
+
+    for (auto i = 0U; i < ps.size(); i += 2) {  // 1つおきに解放すると、空き領域は連結できない
+        mrt.deallocate(ps[i], 48);
+    }
+
+    auto const fragmented = mrt.get_stats();
+    ASSERT_EQ(fragmented.free_bytes, mrt.get_count());
+    ASSERT_EQ(8, fragmented.used_blocks);
+    ASSERT_EQ(9, fragmented.free_blocks);  // 8ブロック + 末尾の未使用領域
+    ASSERT_LT(0.0, fragmented.fragmentation());
+
+    for (auto i = 1U; i < ps.size(); i += 2) {
+        mrt.deallocate(ps[i], 48);
+    }
+
+    ASSERT_EQ(1, mrt.get_stats().free_blocks);
+}
+
+TEST(NewDelete, memory_resource_tlsf_random)
+{
+    memory_resource_tlsf<64 * 1024> mrt;
+    auto const                      count = mrt.get_count();
+
+    auto rng  = std::mt19937{2};
+    auto size = std::uniform_int_distribution<size_t>{1, 1024};
+    auto live = std::vector<std::pair<uint8_t*, size_t>>(64, {nullptr, 0});
+
+    for (auto i = 0; i < 2000; ++i) {
+        auto& [p, n] = live[i % live.size()];
+
+        if (p != nullptr) {
+            for (auto j = 0U; j < n; ++j) {  // 他のブロックに上書きされていないこと
+                ASSERT_EQ(static_cast<uint8_t>(n), p[j]);
+            }
+            mrt.deallocate(p, n);
+        }
+
+        n = size(rng);
+        p = static_cast<uint8_t*>(mrt.allocate(n));
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t));
+        std::memset(p, static_cast<uint8_t>(n), n);
+    }
+
+    for (auto& [p, n] : live) {
+        mrt.deallocate(p, n);
+    }
+
+    ASSERT_EQ(count, mrt.get_count());
+    ASSERT_EQ(1, mrt.get_stats().free_blocks);
+}
+
+/// @brief フラグメンテーションを起こしながら確保/解放を1回ずつ計測し、最悪値とp99.9を求める
+PerformanceStats measure_latency(std::pmr::memory_resource& mr, char const* name)
+{
+    auto rng   = std::mt19937{1};
+    auto sizes = std::uniform_int_distribution<size_t>{8, 512};
+    auto slots = std::uniform_int_distribution<size_t>{0, 511};
+
+    auto live = std::vector<std::pair<void*, size_t>>(512, {nullptr, 0});
+
+    auto options           = MeasureOptions{};
+    options.warmup         = 10'000;
+    options.samples        = 100'000;
+    options.ops_per_sample = 1;
+
+    auto stats = RecordBenchmark(
+        name, MeasurePerformanceStats(options, [&] {
+            auto& [p, size] = live[slots(rng)];
+            if (p != nullptr) {
+                mr.deallocate(p, size);
+            }
+
+            size = sizes(rng);
+            p    = mr.allocate(size);
+        }));
+
+    for (auto& [p, size] : live) {
+        if (p != nullptr) {
+            mr.deallocate(p, size);
+        }
+    }
+
+    std::cout << name << " : median:" << stats.median_ns << "ns p99:" << stats.p99_ns
+              << "ns p99.9:" << Percentile(stats.samples_ns, 99.9) << "ns max:" << stats.samples_ns.back() << "ns"
+              << std::endl;
+
+    return stats;
+}
+
+TEST(Benchmark, memory_resource_tlsf)
+{
+    constexpr uint32_t mem_size = 512 * 1024;
+
+    auto mrv  = std::make_unique<memory_resource_variable<mem_size>>();
+    auto mrt  = std::make_unique<memory_resource_tlsf<mem_size>>();
+    auto pool = std::pmr::unsynchronized_pool_resource{};
+
+    measure_latency(*mrv, "latency/memory_resource_variable");
+    measure_latency(*mrt, "latency/memory_resource_tlsf");
+    measure_latency(pool, "latency/unsynchronized_pool_resource");
+
+    ASSERT_EQ(1, mrt->get_stats().free_blocks);
+}
+}  // namespace
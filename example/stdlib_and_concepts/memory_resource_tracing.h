@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "instrumented_lock.h"
+#include "memory_resource_variable.h"
+#include "spin_lock.h"
+#include "suppress_warning.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+/// @brief log2バケットのヒストグラム。バケットiは[2^(i-1), 2^i)の度数。バケット0は0
+using alloc_histogram_t = std::array<uint64_t, 64>;
+
+enum class alloc_kind : uint8_t { allocate, deallocate };
+
+/// @brief アロケーショントレースの1イベント
+struct alloc_event_t {
+    alloc_kind kind{alloc_kind::allocate};
+    uint32_t   thread{0};     ///< Inner_::ThreadIndex()
+    uint64_t   time_ns{0};    ///< トレース開始からの経過時間
+    uint64_t   id{0};         ///< 確保毎に一意な番号。解放イベントは対応する確保と同じ番号を持つ
+    size_t     size{0};       ///< 解放イベントでは対応する確保のサイズ
+    size_t     alignment{0};  ///< 解放イベントでは対応する確保のアライメント
+};
+
+inline bool operator==(alloc_event_t const& lhs, alloc_event_t const& rhs) noexcept
+{
+    return lhs.kind == rhs.kind && lhs.thread == rhs.thread && lhs.time_ns == rhs.time_ns && lhs.id == rhs.id
+           && lhs.size == rhs.size && lhs.alignment == rhs.alignment;
+}
+
+/// @brief memory_resource_tracingの統計のスナップショット
+struct alloc_trace_stats_t {
+    uint64_t          allocations{0};
+    uint64_t          deallocations{0};
+    size_t            live_bytes{0};          ///< 確保中のバイト数(要求サイズの合計)
+    size_t            peak_bytes{0};          ///< live_bytesの最大値(ハイウォーターマーク)
+    alloc_histogram_t size_histogram{};       ///< 要求サイズ[byte]の分布
+    alloc_histogram_t alignment_histogram{};  ///< 要求アライメント[byte]の分布
+    alloc_histogram_t lifetime_histogram{};   ///< 確保から解放までの時間[ns]の分布
+    uint64_t          lost_events{0};         ///< 記録領域を確保できず、トレースから欠落した解放イベントの数
+};
+
+inline std::ostream& operator<<(std::ostream& os, alloc_trace_stats_t const& stats)
+{
+    return os << "allocations:" << stats.allocations << " deallocations:" << stats.deallocations
+              << " live:" << stats.live_bytes << "bytes peak:" << stats.peak_bytes
+              << "bytes size p50:" << HistogramPercentile(stats.size_histogram, 50)
+              << " p99:" << HistogramPercentile(stats.size_histogram, 99)
+              << " lifetime p50:" << HistogramPercentile(stats.lifetime_histogram, 50)
+              << "ns p99:" << HistogramPercentile(stats.lifetime_histogram, 99)
+              << "ns lost_events:" << stats.lost_events;
+}
+
+namespace Inner_ {
+
+inline size_t alloc_histogram_bucket(uint64_t v) noexcept { return v == 0 ? 0 : 64 - __builtin_clzll(v); }
+
+inline uint64_t steady_now_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// トレースのバイナリ形式
+//   ヘッダ: alloc_trace_magic
+//   イベント: varint((thread << 1) | kind), varint(前イベントからの経過時間[ns]), varint(id)
+//             確保イベントのみ、続けてvarint(size), log2(alignment)の1バイト
+constexpr char alloc_trace_magic[4] = {'P', 'M', 'R', '1'};
+
+inline void write_varint(std::ostream& os, uint64_t v)
+{
+    while (v >= 0x80) {
+        os.put(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    os.put(static_cast<char>(v));
+}
+
+inline bool read_varint(std::istream& is, uint64_t& v)
+{
+    v = 0;
+    for (auto shift = 0U; shift < 64; shift += 7) {
+        auto const c = is.get();
+        if (c == std::istream::traits_type::eof()) {
+            return false;
+        }
+
+        v |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+}  // namespace Inner_
+
+/// @brief イベント列をコンパクトなバイナリ形式でosに書き出す。イベントはtime_nsの昇順でなければならない
+inline void write_alloc_trace(std::ostream& os, std::vector<alloc_event_t> const& events)
+{
+    os.write(Inner_::alloc_trace_magic, sizeof(Inner_::alloc_trace_magic));
+
+    auto prev_ns = uint64_t{0};
+    for (auto const& e : events) {
+        Inner_::write_varint(os, (uint64_t{e.thread} << 1) | static_cast<uint64_t>(e.kind));
+        Inner_::write_varint(os, e.time_ns - prev_ns);
+        Inner_::write_varint(os, e.id);
+
+        if (e.kind == alloc_kind::allocate) {
+            Inner_::write_varint(os, e.size);
+            os.put(static_cast<char>(Inner_::alloc_histogram_bucket(e.alignment) - 1));
+        }
+
+        prev_ns = e.time_ns;
+    }
+}
+
+/// @brief write_alloc_traceで書き出したトレースを読み込む。形式が不正な場合、std::runtime_errorを送出する
+inline std::vector<alloc_event_t> read_alloc_trace(std::istream& is)
+{
+    char magic[sizeof(Inner_::alloc_trace_magic)]{};
+    if (!is.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), Inner_::alloc_trace_magic)) {
+        throw std::runtime_error{"not an allocation trace"};
+    }
+
+    auto events = std::vector<alloc_event_t>{};
+    auto live   = std::unordered_map<uint64_t, std::pair<size_t, size_t>>{};  // id -> (size, alignment)
+    auto time   = uint64_t{0};
+
+    for (uint64_t tag; Inner_::read_varint(is, tag);) {
+        auto e   = alloc_event_t{};
+        e.kind   = static_cast<alloc_kind>(tag & 1);
+        e.thread = static_cast<uint32_t>(tag >> 1);
+
+        uint64_t delta;
+        if (!Inner_::read_varint(is, delta) || !Inner_::read_varint(is, e.id)) {
+            throw std::runtime_error{"truncated allocation trace"};
+        }
+        time += delta;
+        e.time_ns = time;
+
+        if (e.kind == alloc_kind::allocate) {
+            uint64_t size;
+            if (!Inner_::read_varint(is, size)) {
+                throw std::runtime_error{"truncated allocation trace"};
+            }
+
+            auto const align_log2 = is.get();
+            if (align_log2 == std::istream::traits_type::eof()) {
+                throw std::runtime_error{"truncated allocation trace"};
+            }
+            if (align_log2 >= 64) {  // size_tのビット数以上のシフトは未定義動作
+                throw std::runtime_error{"invalid alignment in allocation trace"};
+            }
+
+            e.size      = size;
+            e.alignment = size_t{1} << align_log2;
+            live[e.id]  = {e.size, e.alignment};
+        }
+        else if (auto it = live.find(e.id); it != live.end()) {
+            e.size      = it->second.first;
+            e.alignment = it->second.second;
+            live.erase(it);
+        }
+
+        events.push_back(e);
+    }
+
+    return events;
+}
+
+/// @brief 任意のstd::pmr::memory_resourceの前段に置き、確保/解放を記録するメモリリソース
+/// @details サイズ、アライメント、寿命のヒストグラムと確保中のバイト数のハイウォーターマークを集計する。
+///          record_eventsがtrueの場合、全イベントを保持し、write_traceでバイナリ形式のトレースとして書き出す。
+///          トレースはリプレイして、サイズクラスの選択やメモリリソースの比較に使う。
+///          記録のための領域はupstreamではなくデフォルトのヒープから確保する。
+template <typename LOCK = SpinLock>
+class memory_resource_tracing final : public std::pmr::memory_resource {
+public:
+    explicit memory_resource_tracing(std::pmr::memory_resource* upstream = std::pmr::get_default_resource(),
+                                     bool                       record_events = true)
+        : upstream_{upstream}, record_events_{record_events}
+    {
+    }
+
+    memory_resource_tracing(memory_resource_tracing const&)            = delete;
+    memory_resource_tracing& operator=(memory_resource_tracing const&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+    alloc_trace_stats_t get_stats() const
+    {
+        auto lock = std::lock_guard{lock_};
+        return stats_;
+    }
+
+    std::vector<alloc_event_t> get_events() const
+    {
+        auto lock = std::lock_guard{lock_};
+        return events_;
+    }
+
+    void write_trace(std::ostream& os) const { write_alloc_trace(os, get_events()); }
+
+private:
+    struct live_t {
+        uint64_t id;
+        uint64_t time_ns;
+    };
+
+    std::pmr::memory_resource* const        upstream_;
+    bool const                              record_events_;
+    uint64_t const                          start_ns_{Inner_::steady_now_ns()};
+    mutable LOCK                            lock_{};
+    uint64_t                                next_id_{0};
+    alloc_trace_stats_t                     stats_{};
+    std::unordered_map<void const*, live_t> live_{};
+    std::vector<alloc_event_t>              events_{};
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        auto* mem = upstream_->allocate(size, alignment);
+
+        try {
+            record_allocation(mem, size, alignment);
+        }
+        catch (...) {  // 記録のための確保に失敗した場合、upstreamから確保した領域をリークさせない
+            upstream_->deallocate(mem, size, alignment);
+            throw;
+        }
+
+        return mem;
+    }
+
+    /// @brief memの確保を記録する。例外が発生した場合、記録は変更しない
+    void record_allocation(void const* mem, size_t size, size_t alignment)
+    {
+        auto lock = std::lock_guard{lock_};
+
+        auto const now = Inner_::steady_now_ns() - start_ns_;  // イベントが時刻順になるように、ロック内で取得する
+        auto const id  = next_id_++;
+        auto const it  = live_.insert_or_assign(mem, live_t{id, now}).first;
+
+        if (record_events_) {
+            try {
+                events_.push_back(alloc_event_t{alloc_kind::allocate, Inner_::ThreadIndex(), now, id, size, alignment});
+            }
+            catch (...) {
+                live_.erase(it);
+                throw;
+            }
+        }
+
+        ++stats_.allocations;
+        stats_.live_bytes += size;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.live_bytes);
+        ++stats_.size_histogram[Inner_::alloc_histogram_bucket(size)];
+        ++stats_.alignment_histogram[Inner_::alloc_histogram_bucket(alignment)];
+    }
+
+    /// @details noexceptなコンテナのデストラクタから呼ばれるため、イベントの記録に失敗しても送出せず、
+    ///          イベントを捨ててlost_eventsに数える。upstreamへの解放は常に行う
+    void do_deallocate(void* mem, size_t size, size_t alignment) noexcept override
+    {
+        {
+            auto       lock = std::lock_guard{lock_};
+            auto const now  = Inner_::steady_now_ns() - start_ns_;
+
+            if (auto it = live_.find(mem); it != live_.end()) {
+                ++stats_.deallocations;
+                stats_.live_bytes -= size;
+                ++stats_.lifetime_histogram[Inner_::alloc_histogram_bucket(now - it->second.time_ns)];
+
+                if (record_events_) {
+                    try {
+                        events_.push_back(alloc_event_t{alloc_kind::deallocate, Inner_::ThreadIndex(), now,
+                                                        it->second.id, size, alignment});
+                    }
+                    catch (...) {
+                        ++stats_.lost_events;
+                    }
+                }
+                live_.erase(it);
+            }
+        }
+
+        upstream_->deallocate(mem, size, alignment);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+/// @brief 1 - 最大の空きブロック / 空き領域の合計。0ならば空き領域は1つにまとまっている
+/// @details 空き領域の合計に対して確保可能な最大サイズがどれだけ小さいかを示す。
+///          mrvの空きリストをロックせずに走査するため、呼び出し側はmrvへの確保/解放と並行して呼び出さないこと
+template <uint32_t MEM_SIZE, typename LOCK>
+double fragmentation_index(memory_resource_variable<MEM_SIZE, LOCK> const& mrv) noexcept
+{
+    auto total   = size_t{0};
+    auto largest = size_t{0};
+
+    for (auto it = mrv.cbegin(); it != mrv.cend(); ++it) {
+        total += (*it)->n_units;
+        largest = std::max(largest, (*it)->n_units);
+    }
+
+    return total == 0 ? 0.0 : 1.0 - static_cast<double>(largest) / total;
+}
+
+SUPPRESS_WARN_END;
@@ -0,0 +1,109 @@
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+#include "memory_resource_tracing.h"
+#include "memory_resource_variable.h"
+#include "suppress_warning.h"
+
+namespace {
+
+using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+
+TEST(NewDelete, memory_resource_tracing)
+{
+    memory_resource_variable<4096> mrv;
+    memory_resource_tracing<>      mrt{&mrv};
+
+    {
+        auto v = std::pmr::vector<int>{&mrt};
+        for (auto i = 0; i < 100; ++i) {  // 4, 8, 16, ... 128個分の再確保
+            v.push_back(i);
+        }
+
+        auto str = pmr_string{"custom allocator!", &mrt};
+        ASSERT_TRUE(mrv.is_valid(str.c_str()));  // upstreamから確保される
+
+        void* p = mrt.allocate(8, 64);
+        mrt.deallocate(p, 8, 64);
+    }
+
+    auto const stats = mrt.get_stats();
+    std::cout << stats << std::endl;
+
+    ASSERT_EQ(stats.allocations, stats.deallocations);
+    ASSERT_EQ(0, stats.live_bytes);
+    ASSERT_EQ(0, stats.lost_events);
+    ASSERT_LE(128 * sizeof(int) + 64 * sizeof(int), stats.peak_bytes);  // 再確保中は新旧の領域が同時に存在する
+    ASSERT_EQ(1, stats.alignment_histogram[7]);                         // 64 == 2^6はバケット7
+    ASSERT_EQ(1, stats.alignment_histogram[1]);                         // alignof(char)
+    ASSERT_EQ(stats.allocations - 2, stats.alignment_histogram[3]);     // alignof(int)
+    ASSERT_EQ(1, stats.size_histogram[10]);                             // 128 * sizeof(int) == 512はバケット10
+
+    // memory_resource_variableの確保中のハイウォーターマーク
+    ASSERT_GE(mrv.get_count() - stats.peak_bytes, mrv.get_count_min());
+}
+
+TEST(NewDelete, memory_resource_tracing_trace)
+{
+    memory_resource_tracing<> mrt;
+
+    void* p0 = mrt.allocate(100);
+    void* p1 = mrt.allocate(1 << 20, 4096);
+    mrt.deallocate(p0, 100);
+    void* p2 = mrt.allocate(7, 1);
+    mrt.deallocate(p2, 7, 1);
+    mrt.deallocate(p1, 1 << 20, 4096);
+
+    auto const events = mrt.get_events();
+    ASSERT_EQ(6, events.size());
+    ASSERT_EQ(alloc_kind::deallocate, events[2].kind);
+    ASSERT_EQ(events[0].id, events[2].id);
+    ASSERT_EQ(100, events[2].size);
+
+    auto oss = std::ostringstream{};
+    mrt.write_trace(oss);
+    ASSERT_GT(events.size() * sizeof(alloc_event_t) / 2, oss.str().size());  // 時刻の差分とvarintで圧縮される
+
+    auto iss = std::istringstream{oss.str()};
+    ASSERT_EQ(events, read_alloc_trace(iss));  // 解放イベントのサイズ、アライメントも復元される
+
+    auto bad = std::istringstream{"XXXX"};
+    ASSERT_THROW(read_alloc_trace(bad), std::runtime_error);
+
+    auto truncated = std::istringstream{oss.str().substr(0, oss.str().size() - 1)};
+    ASSERT_THROW(read_alloc_trace(truncated), std::runtime_error);
+
+    // 確保イベント(タグ0, 時刻差0, id 0, サイズ8)のアライメントが2^64
+    auto const invalid_alignment = std::string{"PMR1"} + std::string{'\0', '\0', '\0', '\x08', '\x40'};
+    auto       invalid           = std::istringstream{invalid_alignment};
+    ASSERT_THROW(read_alloc_trace(invalid), std::runtime_error);
+}
+
+TEST(NewDelete, memory_resource_fragmentation_index)
+{
+    memory_resource_variable<4096> mrv;
+    ASSERT_DOUBLE_EQ(0.0, fragmentation_index(mrv));
+
+    auto ps = std::vector<void*>{};
+    for (auto i = 0; i < 16; ++i) {
+        ps.push_back(mrv.allocate(64));
+    }
+
+    for (auto i = 0U; i < ps.size(); i += 2) {  // 1つおきに解放して空き領域を分断する
+        mrv.deallocate(ps[i], 64);
+    }
+    ASSERT_LT(0.0, fragmentation_index(mrv));
+
+    for (auto i = 1U; i < ps.size(); i += 2) {
+        mrv.deallocate(ps[i], 64);
+    }
+    ASSERT_DOUBLE_EQ(0.0, fragmentation_index(mrv));  // 連結により1つの空き領域に戻る
+}
+}  // namespace
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
+
+#include "spin_lock.h"
+#include "suppress_warning.h"
+#include "utils.h"
+
+SUPPRESS_WARN_BEGIN;
+SUPPRESS_WARN_GCC_NOT_EFF_CPP;
+
+namespace Inner_ {
+
+struct header_t {
+    header_t* next;
+    size_t    n_units;  // header_tが何個あるか
+};
+
+constexpr auto unit_size = sizeof(header_t);
+
+inline std::optional<header_t*> sprit(header_t* header, size_t n_units) noexcept
+{
+    assert(n_units > 1);  // ヘッダとバッファなので最低でも2
+
+    if (header->n_units == n_units || header->n_units == n_units + 1) {
+        return header->next;
+    }
+    else if (header->n_units > n_units) {
+        auto next       = header + n_units;
+        next->n_units   = header->n_units - n_units;
+        next->next      = header->next;
+        header->n_units = n_units;
+        return next;
+    }
+
+    return std::nullopt;
+}
+
+inline void concat(header_t* front, header_t* rear) noexcept
+{
+    if (front + front->n_units == rear) {  // 1枚のメモリになる
+        front->n_units += rear->n_units;
+        front->next = rear->next;
+    }
+    else {
+        front->next = rear;
+    }
+}
+
+inline header_t* set_back(void* mem) noexcept { return static_cast<header_t*>(mem) - 1; }
+
+/// @brief header + 1からのメモリがalignmentに整列するように、headerの先頭を空きブロックとして切り離す
+/// @return 整列したヘッダ(切り離し不要ならheader)。n_unitsを確保できない場合はnullptr
+inline header_t* align_front(header_t* header, size_t n_units, size_t alignment) noexcept
+{
+    if (alignment <= unit_size) {
+        return header;
+    }
+
+    auto const addr = reinterpret_cast<uintptr_t>(header + 1);
+    auto const pad  = ((alignment - addr % alignment) % alignment) / unit_size;  // 先頭に残すheader_tの数
+
+    if (pad == 0) {
+        return header;
+    }
+
+    if (header->n_units < pad + n_units) {
+        return nullptr;
+    }
+
+    auto aligned     = header + pad;
+    aligned->n_units = header->n_units - pad;
+    aligned->next    = header->next;
+    header->n_units  = pad;
+    header->next     = aligned;
+
+    return aligned;
+}
+
+static_assert(sizeof(header_t) == alignof(std::max_align_t));
+
+template <uint32_t MEM_SIZE>
+struct buffer_t {
+    alignas(alignof(std::max_align_t)) uint8_t buffer[Roundup(sizeof(header_t), MEM_SIZE)];
+};
+
+/// @brief スレッド毎に一意な番号(0, 1, 2, ...)
+inline uint32_t ThreadIndex() noexcept
+{
+    static std::atomic<uint32_t> counter{0};
+    thread_local auto const      index = counter.fetch_add(1, std::memory_order_relaxed);
+
+    return index;
+}
+}  // namespace Inner_
+
+/// @brief 何もしないロック。外側で排他制御されるメモリリソースの内部で使用する
+struct NullLock {
+    void lock() noexcept {}
+    bool try_lock() noexcept { return true; }
+    void unlock() noexcept {}
+};
+
+// @@@ sample begin 0:0
+
+template <uint32_t MEM_SIZE, typename LOCK = SpinLock>  // LOCKはstd::lock_guardで使用できる型
+class memory_resource_variable final : public std::pmr::memory_resource {
+public:
+    memory_resource_variable() noexcept
+    {
+        header_->next    = nullptr;
+        header_->n_units = sizeof(buff_) / Inner_::unit_size;
+    }
+
+    size_t get_count() const noexcept { return unit_count_ * Inner_::unit_size; }
+    size_t get_count_min() const noexcept { return unit_count_min_ * Inner_::unit_size; }  // get_count()の最小値
+    bool   is_valid(void const* mem) const noexcept
+    {
+        return (&buff_ < mem) && (mem < &buff_.buffer[ArrayLength(buff_.buffer)]);
+    }
+
+    // @@@ ignore begin
+    class const_iterator {
+    public:
+        explicit const_iterator(Inner_::header_t const* header) noexcept : header_{header} {}
+        const_iterator(const_iterator const&) = default;
+        const_iterator(const_iterator&&)      = default;
+
+        const_iterator& operator++() noexcept  // 前置++のみ実装
+        {
+            assert(header_ != nullptr);
+            header_ = header_->next;
+
+            return *this;
+        }
+
+        Inner_::header_t const* operator*() noexcept { return header_; }
+
+        // clang-format off
+
+    #if __cplusplus <= 201703L  // c++17
+        bool operator==(const_iterator const& rhs) noexcept { return header_ == rhs.header_; }
+        bool operator!=(const_iterator const& rhs) noexcept { return !(*this == rhs); }
+    #else  // c++20
+
+        auto operator<=>(const const_iterator&) const = default;
+    #endif
+        // clang-format on
+
+    private:
+        Inner_::header_t const* header_;
+    };
+
+    const_iterator begin() const noexcept { return const_iterator{header_}; }
+    const_iterator end() const noexcept { return const_iterator{nullptr}; }
+    const_iterator cbegin() const noexcept { return const_iterator{header_}; }
+    const_iterator cend() const noexcept { return const_iterator{nullptr}; }
+    // @@@ ignore end
+
+private:
+    using header_t = Inner_::header_t;
+
+    Inner_::buffer_t<MEM_SIZE> buff_{};
+    header_t*                  header_{reinterpret_cast<header_t*>(buff_.buffer)};
+    mutable LOCK               lock_{};
+    size_t                     unit_count_{sizeof(buff_) / Inner_::unit_size};
+    size_t                     unit_count_min_{sizeof(buff_) / Inner_::unit_size};
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        auto n_units = (Roundup(Inner_::unit_size, size) / Inner_::unit_size) + 1;
+
+        auto lock = std::lock_guard{lock_};
+
+        auto curr = header_;
+
+        for (header_t* prev{nullptr}; curr != nullptr; prev = curr, curr = curr->next) {
+            if (auto aligned = align_front(curr, n_units, alignment); aligned != curr) {
+                if (aligned == nullptr) {
+                    continue;
+                }
+                prev = curr;  // 整列のために切り離した先頭は、空きブロックとして残る
+                curr = aligned;
+            }
+
+            auto opt_next = std::optional<header_t*>{sprit(curr, n_units)};
+
+            if (!opt_next) {
+                continue;
+            }
+
+            auto next = *opt_next;
+            if (prev == nullptr) {
+                header_ = next;
+            }
+            else {
+                prev->next = next;
+            }
+            break;
+        }
+
+        if (curr != nullptr) {
+            unit_count_ -= curr->n_units;
+            unit_count_min_ = std::min(unit_count_, unit_count_min_);
+            ++curr;
+        }
+
+        if (curr == nullptr) {
+            throw std::bad_alloc{};
+        }
+
+        return curr;
+    }
+
+    void do_deallocate(void* mem, size_t, size_t) noexcept override
+    {
+        header_t* to_free = Inner_::set_back(mem);
+
+        to_free->next = nullptr;
+
+        auto lock = std::lock_guard{lock_};
+
+        unit_count_ += to_free->n_units;
+        unit_count_min_ = std::min(unit_count_, unit_count_min_);
+
+        if (header_ == nullptr) {
+            header_ = to_free;
+            return;
+        }
+
+        if (to_free < header_) {
+            concat(to_free, header_);
+            header_ = to_free;
+            return;
+        }
+
+        header_t* curr = header_;
+
+        for (; curr->next != nullptr; curr = curr->next) {
+            if (to_free < curr->next) {  // 常に curr < to_free
+                concat(to_free, curr->next);
+                concat(curr, to_free);
+                return;
+            }
+        }
+
+        concat(curr, to_free);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+// @@@ sample end
+
+SUPPRESS_WARN_END;
@@ -1,244 +1,175 @@
-#include <cassert>
 #include <cstdint>
+#include <iostream>
 #include <memory_resource>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "gtest_wrapper.h"
 
+#include "adaptive_lock.h"
+#include "benchmark_gate.h"
+#include "instrumented_lock.h"
+#include "measure_contention.h"
+#include "measure_performance.h"
+#include "memory_resource_variable.h"
 #include "spin_lock.h"
 #include "suppress_warning.h"
-#include "utils.h"
 
-SUPPRESS_WARN_BEGIN;
-SUPPRESS_WARN_GCC_NOT_EFF_CPP;
-
-namespace Inner_ {
-
-struct header_t {
-    header_t* next;
-    size_t    n_units;  // header_tが何個あるか
-};
-
-constexpr auto unit_size = sizeof(header_t);
-
-inline std::optional<header_t*> sprit(header_t* header, size_t n_units) noexcept
+namespace {
+TEST(NewDelete, pmr_memory_resource)
 {
-    assert(n_units > 1);  // ヘッダとバッファなので最低でも2
+    // @@@ sample begin 1:0
 
-    if (header->n_units == n_units || header->n_units == n_units + 1) {
-        return header->next;
-    }
-    else if (header->n_units > n_units) {
-        auto next       = header + n_units;
-        next->n_units   = header->n_units - n_units;
-        next->next      = header->next;
-        header->n_units = n_units;
-        return next;
-    }
+    constexpr uint32_t            max = 1024;
+    memory_resource_variable<max> mrv;
+    memory_resource_variable<max> mrv2;
 
-    return std::nullopt;
-}
+    ASSERT_EQ(mrv, mrv);
+    ASSERT_NE(mrv, mrv2);
 
-inline void concat(header_t* front, header_t* rear) noexcept
-{
-    if (front + front->n_units == rear) {  // 1枚のメモリになる
-        front->n_units += rear->n_units;
-        front->next = rear->next;
-    }
-    else {
-        front->next = rear;
-    }
-}
+    {
+        auto remaings1 = mrv.get_count();
 
-inline header_t* set_back(void* mem) noexcept { return static_cast<header_t*>(mem) - 1; }
+        ASSERT_GE(max, remaings1);
 
-static_assert(sizeof(header_t) == alignof(std::max_align_t));
+        // std::basic_stringにカスタムアロケータを適用
+        using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+        std::pmr::polymorphic_allocator<char> allocator(&mrv);
 
-template <uint32_t MEM_SIZE>
-struct buffer_t {
-    alignas(alignof(std::max_align_t)) uint8_t buffer[Roundup(sizeof(header_t), MEM_SIZE)];
-};
-}  // namespace Inner_
+        // カスタムアロケータを使って文字列を作成
+        pmr_string str("custom allocator!", allocator);
+        auto       remaings2 = mrv.get_count();
+        // アサーション: 文字列の内容を確認
 
-// @@@ sample begin 0:0
+        ASSERT_GT(remaings1, remaings2);
+        ASSERT_EQ("custom allocator!", str);
 
-template <uint32_t MEM_SIZE>
-class memory_resource_variable final : public std::pmr::memory_resource {
-public:
-    memory_resource_variable() noexcept
-    {
-        header_->next    = nullptr;
-        header_->n_units = sizeof(buff_) / Inner_::unit_size;
-    }
+        ASSERT_TRUE(mrv.is_valid(str.c_str()));  // strの内部メモリがmrvの内部であることの確認
 
-    size_t get_count() const noexcept { return unit_count_ * Inner_::unit_size; }
-    bool   is_valid(void const* mem) const noexcept
-    {
-        return (&buff_ < mem) && (mem < &buff_.buffer[ArrayLength(buff_.buffer)]);
+        auto str3 = str + str + str;
+        ASSERT_EQ(str.size() * 3 + 1, str3.size() + 1);
+        ASSERT_THROW(str3 = pmr_string(2000, 'a'), std::bad_alloc);  // メモリの枯渇テスト
     }
 
-    // @@@ ignore begin
-    class const_iterator {
-    public:
-        explicit const_iterator(Inner_::header_t const* header) noexcept : header_{header} {}
-        const_iterator(const_iterator const&) = default;
-        const_iterator(const_iterator&&)      = default;
-
-        const_iterator& operator++() noexcept  // 前置++のみ実装
-        {
-            assert(header_ != nullptr);
-            header_ = header_->next;
+    ASSERT_GE(max, mrv.get_count());  // 解放後のメモリの回復のテスト
+    // @@@ sample end
+}
 
-            return *this;
+TEST(NewDelete, pmr_memory_resource_profile)
+{
+    // LOCKをInstrumentedLockにすると、ロックの競合をプロファイルできる
+    memory_resource_variable<4096, InstrumentedLock<SpinLock>> mrv;
+
+    auto const stats = MeasureContention(ContentionOptions{2, 1000, false}, [&mrv] {
+        void* p = mrv.allocate(64);
+        DoNotOptimize(p);
+        mrv.deallocate(p, 64);
+    });
+
+    for (auto const& site : LockProfiler::Instance().Snapshot()) {
+        if (site.name == "SpinLock") {  // ロックサイト名を指定しない場合、ラップしたロックの型名となる
+            ASSERT_LE(2 * stats.total_ops, site.acquisitions);  // allocateとdeallocateで1回ずつ
+            std::cout << site << std::endl;
         }
+    }
+}
 
-        Inner_::header_t const* operator*() noexcept { return header_; }
-
-        // clang-format off
-
-    #if __cplusplus <= 201703L  // c++17
-        bool operator==(const_iterator const& rhs) noexcept { return header_ == rhs.header_; }
-        bool operator!=(const_iterator const& rhs) noexcept { return !(*this == rhs); }
-    #else  // c++20
-
-        auto operator<=>(const const_iterator&) const = default;
-    #endif
-        // clang-format on
-
-    private:
-        Inner_::header_t const* header_;
+TEST(NewDelete, pmr_memory_resource_aligned)
+{
+    struct alignas(64) Lanes {  // キャッシュライン、AVX-512に整列したSIMD用のデータ
+        float v[16];
     };
 
-    const_iterator begin() const noexcept { return const_iterator{header_}; }
-    const_iterator end() const noexcept { return const_iterator{nullptr}; }
-    const_iterator cbegin() const noexcept { return const_iterator{header_}; }
-    const_iterator cend() const noexcept { return const_iterator{nullptr}; }
-    // @@@ ignore end
+    memory_resource_variable<4096> mrv;
+    auto const                     count = mrv.get_count();
 
-private:
-    using header_t = Inner_::header_t;
-
-    Inner_::buffer_t<MEM_SIZE> buff_{};
-    header_t*                  header_{reinterpret_cast<header_t*>(buff_.buffer)};
-    mutable SpinLock           spin_lock_{};
-    size_t                     unit_count_{sizeof(buff_) / Inner_::unit_size};
-    size_t                     unit_count_min_{sizeof(buff_) / Inner_::unit_size};
-
-    void* do_allocate(size_t size, size_t) override
     {
-        auto n_units = (Roundup(Inner_::unit_size, size) / Inner_::unit_size) + 1;
-
-        auto lock = std::lock_guard{spin_lock_};
-
-        auto curr = header_;
-
-        for (header_t* prev{nullptr}; curr != nullptr; prev = curr, curr = curr->next) {
-            auto opt_next = std::optional<header_t*>{sprit(curr, n_units)};
-
-            if (!opt_next) {
-                continue;
-            }
-
-            auto next = *opt_next;
-            if (prev == nullptr) {
-                header_ = next;
-            }
-            else {
-                prev->next = next;
-            }
-            break;
-        }
-
-        if (curr != nullptr) {
-            unit_count_ -= curr->n_units;
-            unit_count_min_ = std::min(unit_count_, unit_count_min_);
-            ++curr;
-        }
-
-        if (curr == nullptr) {
-            throw std::bad_alloc{};
-        }
-
-        return curr;
+        void* p0 = mrv.allocate(8);  // 以後の確保が64バイト境界からずれるようにする
+        void* p1 = mrv.allocate(40, 64);
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(p1) % 64);
+        void* p2 = mrv.allocate(8, 32);
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(p2) % 32);
+
+        mrv.deallocate(p1, 40, 64);
+        mrv.deallocate(p0, 8);
+        mrv.deallocate(p2, 8, 32);
     }
+    ASSERT_EQ(count, mrv.get_count());  // 整列のために切り離した領域も回復する
 
-    void do_deallocate(void* mem, size_t, size_t) noexcept override
     {
-        header_t* to_free = Inner_::set_back(mem);
-
-        to_free->next = nullptr;
+        auto lanes = std::pmr::vector<Lanes>{&mrv};
 
-        auto lock = std::lock_guard{spin_lock_};
-
-        unit_count_ += to_free->n_units;
-        unit_count_min_ = std::min(unit_count_, unit_count_min_);
-
-        if (header_ == nullptr) {
-            header_ = to_free;
-            return;
+        for (auto i = 0; i < 8; ++i) {
+            lanes.push_back(Lanes{});
+            ASSERT_EQ(0, reinterpret_cast<uintptr_t>(lanes.data()) % 64);
+            ASSERT_TRUE(mrv.is_valid(lanes.data()));
         }
 
-        if (to_free < header_) {
-            concat(to_free, header_);
-            header_ = to_free;
-            return;
+        for (auto& l : lanes) {  // ベクトル化されるループ
+            for (auto j = 0; j < 16; ++j) {
+                l.v[j] = static_cast<float>(j);
+            }
         }
 
-        header_t* curr = header_;
-
-        for (; curr->next != nullptr; curr = curr->next) {
-            if (to_free < curr->next) {  // 常に curr < to_free
-                concat(to_free, curr->next);
-                concat(curr, to_free);
-                return;
+        auto sum = 0.0F;
+        for (auto const& l : lanes) {
+            for (auto f : l.v) {
+                sum += f;
             }
         }
-
-        concat(curr, to_free);
+        ASSERT_FLOAT_EQ(8 * 120.0F, sum);
     }
+    ASSERT_EQ(count, mrv.get_count());
+}
 
-    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
-};
-// @@@ sample end
-
-namespace {
-TEST(NewDelete, pmr_memory_resource)
+TEST(Benchmark, pmr_memory_resource)
 {
-    // @@@ sample begin 1:0
-
-    constexpr uint32_t            max = 1024;
+    constexpr uint32_t            max = 4096;
     memory_resource_variable<max> mrv;
-    memory_resource_variable<max> mrv2;
+    auto const                    count = mrv.get_count();
 
-    ASSERT_EQ(mrv, mrv);
-    ASSERT_NE(mrv, mrv2);
+    auto options           = MeasureOptions{};
+    options.warmup         = 100;
+    options.samples        = 20;
+    options.ops_per_sample = 1000;
+    options.perf_counters  = true;
 
-    {
-        auto remaings1 = mrv.get_count();
+    auto stats = RecordBenchmark("memory_resource_variable/allocate_deallocate",
+                                 MeasurePerformanceStats(options, [&mrv] {
+                                     void* p = mrv.allocate(64);
+                                     DoNotOptimize(p);
+                                     mrv.deallocate(p, 64);
+                                 }));
 
-        ASSERT_GE(max, remaings1);
+    std::cout << "memory_resource_variable allocate/deallocate : " << stats << std::endl;
 
-        // std::basic_stringにカスタムアロケータを適用
-        using pmr_string = std::basic_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
-        std::pmr::polymorphic_allocator<char> allocator(&mrv);
-
-        // カスタムアロケータを使って文字列を作成
-        pmr_string str("custom allocator!", allocator);
-        auto       remaings2 = mrv.get_count();
-        // アサーション: 文字列の内容を確認
+    ASSERT_EQ(count, mrv.get_count());
+}
 
-        ASSERT_GT(remaings1, remaings2);
-        ASSERT_EQ("custom allocator!", str);
+template <typename LOCK>
+void measure_memory_resource_contention(char const* name)
+{
+    memory_resource_variable<4096, LOCK> mrv;
+    auto const                           count = mrv.get_count();
 
-        ASSERT_TRUE(mrv.is_valid(str.c_str()));  // strの内部メモリがmrvの内部であることの確認
+    for (auto threads : {1U, 2U, 4U}) {
+        auto const stats = MeasureContention(ContentionOptions{threads, 20'000, true}, [&mrv] {
+            void* p = mrv.allocate(64);
+            DoNotOptimize(p);
+            mrv.deallocate(p, 64);
+        });
 
-        auto str3 = str + str + str;
-        ASSERT_EQ(str.size() * 3 + 1, str3.size() + 1);
-        ASSERT_THROW(str3 = pmr_string(2000, 'a'), std::bad_alloc);  // メモリの枯渇テスト
+        std::cout << name << stats << std::endl;
     }
 
-    ASSERT_GE(max, mrv.get_count());  // 解放後のメモリの回復のテスト
-    // @@@ sample end
+    ASSERT_EQ(count, mrv.get_count());
+}
+
+TEST(Benchmark, pmr_memory_resource_lock)
+{
+    measure_memory_resource_contention<SpinLock>("memory_resource_variable<SpinLock>     ");
+    measure_memory_resource_contention<AdaptiveLock>("memory_resource_variable<AdaptiveLock> ");
+    measure_memory_resource_contention<std::mutex>("memory_resource_variable<std::mutex>   ");
 }
 }  // namespace
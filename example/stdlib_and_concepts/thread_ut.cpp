@@ -1,8 +1,10 @@
 #include <atomic>
+#include <iostream>
 #include <thread>
 
 #include "gtest_wrapper.h"
 
+#include "measure_contention.h"
 #include "suppress_warning.h"
 
 namespace conflict {
@@ -87,6 +89,19 @@ TEST(ExpTerm, thread)
     ASSERT_EQ(c.count_, expected);
     // @@@ sample end
 }
+
+TEST(Benchmark, thread_mutex)
+{
+    Conflict c;
+    uint64_t expected = 0;
+
+    for (auto const& stats : SweepContention(100'000, [&c] { c.increment(); })) {
+        std::cout << "std::mutex " << stats << std::endl;
+        expected += stats.total_ops;
+    }
+
+    ASSERT_EQ(c.count_, expected);
+}
 }  // namespace no_conflict
 namespace atomic {
 // @@@ sample begin 2:0
@@ -128,6 +143,19 @@ TEST(ExpTerm, thread)
     ASSERT_EQ(c.count_, expected);
     // @@@ sample end
 }
+
+TEST(Benchmark, thread_atomic)
+{
+    Conflict c;
+    uint64_t expected = 0;
+
+    for (auto const& stats : SweepContention(100'000, [&c] { c.increment(); })) {
+        std::cout << "std::atomic " << stats << std::endl;
+        expected += stats.total_ops;
+    }
+
+    ASSERT_EQ(c.count_, expected);
+}
 }  // namespace atomic
 
 namespace {
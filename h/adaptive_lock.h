@@ -0,0 +1,112 @@
+#pragma once
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "spin_lock.h"
+
+namespace Inner_ {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+/// @brief wordの値がexpectedである間、スレッドを休止させる(spurious wakeupあり)
+inline void FutexWait(std::atomic<uint32_t>& word, uint32_t expected) noexcept
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    static_cast<void>(word);
+    static_cast<void>(expected);
+    std::this_thread::yield();
+#endif
+}
+
+/// @brief FutexWaitで休止しているスレッドを最大count個起床させる
+inline void FutexWake(std::atomic<uint32_t>& word, int count) noexcept
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    static_cast<void>(word);
+    static_cast<void>(count);
+#endif
+}
+}  // namespace Inner_
+
+/// @brief 一定回数スピンしてもロックを獲得できなければfutexで休止するロック
+/// @details 競合がなければ、lock/unlockはそれぞれアトミック命令1つで終わりシステムコールを呼ばない。
+///          スピン回数の上限は、過去にスピンで獲得できた回数の移動平均から自動調整されるため、
+///          クリティカルセクションが短ければスピンで、長ければ(保持スレッドが休止していれば)休止で待つ。
+///          SpinLockと同じlock/unlock/try_lockを持つため、std::lock_guard、std::scoped_lock等で使用できる。
+class AdaptiveLock {
+public:
+    void lock() noexcept
+    {
+        if (!try_lock()) {
+            lock_slow();
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        auto expected = unlocked;
+        return state_.compare_exchange_strong(expected, locked, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept
+    {
+        if (state_.exchange(unlocked, std::memory_order_release) == contended) {
+            Inner_::FutexWake(state_, 1);  // 休止しているスレッドがいる可能性がある場合のみ起こす
+        }
+    }
+
+    /// @brief 現在のスピン回数の推定値
+    int32_t spin_limit() const noexcept { return spin_limit_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t unlocked  = 0;
+    static constexpr uint32_t locked    = 1;  // 休止しているスレッドはいない
+    static constexpr uint32_t contended = 2;  // 休止しているスレッドがいる可能性がある
+
+    static constexpr int32_t max_spin = 1000;
+
+    void lock_slow() noexcept
+    {
+        auto const limit = spin_limit_.load(std::memory_order_relaxed);
+        auto const max   = std::min(2 * limit + 10, max_spin);
+
+        for (auto spin = 0; spin < max; ++spin) {
+            CpuRelax();
+
+            if (state_.load(std::memory_order_relaxed) == unlocked && try_lock()) {
+                update_spin_limit(limit, spin);
+                return;
+            }
+        }
+
+        update_spin_limit(limit, max);
+
+        // スピンで獲得できなかったため、contendedにして休止する
+        // exchangeでunlockedから獲得した場合も、他の休止スレッドがいる可能性があるためcontendedのままにする
+        while (state_.exchange(contended, std::memory_order_acquire) != unlocked) {
+            Inner_::FutexWait(state_, contended);
+        }
+    }
+
+    void update_spin_limit(int32_t limit, int32_t spin) noexcept
+    {
+        spin_limit_.store(limit + (spin - limit) / 8, std::memory_order_relaxed);  // 指数移動平均
+    }
+
+    std::atomic<uint32_t> state_{unlocked};
+    std::atomic<int32_t>  spin_limit_{0};
+};
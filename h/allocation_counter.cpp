@@ -0,0 +1,99 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+// このファイルをリンクした実行ファイルでは、グローバルなoperator new/deleteが下記に置き換わる
+
+namespace {
+
+bool const installed = (Inner_::allocation_counter_installed = true);
+
+void count_allocation(size_t size) noexcept
+{
+    ++Inner_::allocation_count.allocations;
+    Inner_::allocation_count.bytes += size;
+}
+
+void* allocate(size_t size, size_t align)
+{
+    if (size == 0) {
+        size = 1;
+    }
+
+    for (;;) {
+        void* mem = nullptr;
+
+        if (align <= alignof(std::max_align_t)) {
+            mem = std::malloc(size);
+        }
+        else {  // aligned_allocのsizeはalignの倍数でなければならない
+            mem = std::aligned_alloc(align, (size + align - 1) / align * align);
+        }
+
+        if (mem != nullptr) {
+            count_allocation(size);
+            return mem;
+        }
+
+        auto handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+void* allocate_nothrow(size_t size, size_t align) noexcept
+{
+    try {
+        return allocate(size, align);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocate(void* mem) noexcept
+{
+    if (mem == nullptr) {
+        return;
+    }
+
+    ++Inner_::allocation_count.deallocations;
+    std::free(mem);
+}
+
+constexpr auto default_align = alignof(std::max_align_t);
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size, default_align); }
+void* operator new[](size_t size) { return allocate(size, default_align); }
+void* operator new(size_t size, std::nothrow_t const&) noexcept { return allocate_nothrow(size, default_align); }
+void* operator new[](size_t size, std::nothrow_t const&) noexcept { return allocate_nothrow(size, default_align); }
+void* operator new(size_t size, std::align_val_t align) { return allocate(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate(size, static_cast<size_t>(align)); }
+
+void* operator new(size_t size, std::align_val_t align, std::nothrow_t const&) noexcept
+{
+    return allocate_nothrow(size, static_cast<size_t>(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align, std::nothrow_t const&) noexcept
+{
+    return allocate_nothrow(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* mem) noexcept { deallocate(mem); }
+void operator delete[](void* mem) noexcept { deallocate(mem); }
+void operator delete(void* mem, std::nothrow_t const&) noexcept { deallocate(mem); }
+void operator delete[](void* mem, std::nothrow_t const&) noexcept { deallocate(mem); }
+void operator delete(void* mem, size_t) noexcept { deallocate(mem); }
+void operator delete[](void* mem, size_t) noexcept { deallocate(mem); }
+void operator delete(void* mem, std::align_val_t) noexcept { deallocate(mem); }
+void operator delete[](void* mem, std::align_val_t) noexcept { deallocate(mem); }
+void operator delete(void* mem, size_t, std::align_val_t) noexcept { deallocate(mem); }
+void operator delete[](void* mem, size_t, std::align_val_t) noexcept { deallocate(mem); }
+void operator delete(void* mem, std::align_val_t, std::nothrow_t const&) noexcept { deallocate(mem); }
+void operator delete[](void* mem, std::align_val_t, std::nothrow_t const&) noexcept { deallocate(mem); }
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+/// @brief スレッド毎のダイナミックメモリアロケーションの統計
+/// @details allocation_counter.cppをリンクすると、グローバルなoperator new/deleteが置き換えられ、
+///          呼び出しスレッドのカウンタが更新される
+struct AllocationCount {
+    uint64_t allocations{0};    ///< operator newの呼び出し回数
+    uint64_t deallocations{0};  ///< operator deleteの呼び出し回数(nullptrを除く)
+    uint64_t bytes{0};          ///< operator newで確保したバイト数の合計
+};
+
+namespace Inner_ {
+inline thread_local AllocationCount allocation_count{};
+inline bool                         allocation_counter_installed{false};
+}  // namespace Inner_
+
+/// @brief allocation_counter.cppがリンクされ、カウンタが有効であればtrue
+inline bool IsAllocationCounterInstalled() noexcept { return Inner_::allocation_counter_installed; }
+
+/// @brief 呼び出しスレッドのこれまでのアロケーションの統計
+inline AllocationCount GetAllocationCount() noexcept { return Inner_::allocation_count; }
+
+/// @brief 生成から現在までの、呼び出しスレッドのアロケーションを計測するスコープ用のプローブ
+/// @details ホットパスのアロケーション回数がmax_allocationsを超えていないことのテスト等に使う
+class AllocationBudget {
+public:
+    explicit AllocationBudget(uint64_t max_allocations = 0) noexcept
+        : start_{GetAllocationCount()}, max_allocations_{max_allocations}
+    {
+    }
+
+    uint64_t allocations() const noexcept { return GetAllocationCount().allocations - start_.allocations; }
+    uint64_t deallocations() const noexcept { return GetAllocationCount().deallocations - start_.deallocations; }
+    uint64_t bytes() const noexcept { return GetAllocationCount().bytes - start_.bytes; }
+
+    /// @brief 生成からのアロケーション回数がmax_allocationsを超えていればtrue
+    bool is_exceeded() const noexcept { return allocations() > max_allocations_; }
+
+private:
+    AllocationCount const start_;
+    uint64_t const        max_allocations_;
+};
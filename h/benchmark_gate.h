@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "gtest_wrapper.h"
+
+#include "benchmark_registry.h"
+
+/// @brief 全テスト終了後に、BenchmarkRegistryの計測結果を出力し、ベースラインと比較するgtestの環境
+/// @details 以下の環境変数で動作を指定する
+///     - BENCHMARK_JSON     : 計測結果をJSONで出力するファイル
+///     - BENCHMARK_CSV      : 計測結果をCSVで出力するファイル(ベースラインとして使用できる)
+///     - BENCHMARK_BASELINE : 比較対象のCSVファイル。統計的に有意に遅くなったベンチマークがあればテスト失敗とする
+class BenchmarkGate : public ::testing::Environment {
+public:
+    void TearDown() override
+    {
+        auto const results = BenchmarkRegistry::Instance().Results();
+
+        if (auto const* json = std::getenv("BENCHMARK_JSON"); json != nullptr) {
+            auto ofs = std::ofstream{json};
+            WriteJson(ofs, results);
+        }
+
+        if (auto const* csv = std::getenv("BENCHMARK_CSV"); csv != nullptr) {
+            auto ofs = std::ofstream{csv};
+            WriteCsv(ofs, results);
+        }
+
+        auto const* baseline_file = std::getenv("BENCHMARK_BASELINE");
+        if (baseline_file == nullptr) {
+            return;
+        }
+
+        auto ifs = std::ifstream{baseline_file};
+        if (!ifs) {
+            ADD_FAILURE() << "cannot open baseline: " << baseline_file;
+            return;
+        }
+
+        for (auto const& report : CompareWithBaseline(ReadCsv(ifs), ToSamples(results))) {
+            std::cout << (report.is_regression ? "[REGRESSION] " : "[bench] ") << report.name
+                      << " baseline:" << report.baseline_median_ns << "ns current:" << report.current_median_ns
+                      << "ns slowdown:" << report.slowdown() << " p:" << report.p_value << std::endl;
+
+            EXPECT_FALSE(report.is_regression) << report.name;
+        }
+    }
+};
+
+inline ::testing::Environment* const benchmark_gate = ::testing::AddGlobalTestEnvironment(new BenchmarkGate);
@@ -0,0 +1,353 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "measure_performance.h"
+
+/// @brief ベンチマーク名とその計測結果
+using BenchmarkResults = std::map<std::string, PerformanceStats>;
+
+/// @brief ベンチマーク名とそのサンプル(1オペレーションあたりの実行時間[ns])
+using BenchmarkSamples = std::map<std::string, std::vector<double>>;
+
+/// @brief ベンチマークの計測結果を名前毎に保持するレジストリ
+class BenchmarkRegistry {
+public:
+    static BenchmarkRegistry& Instance()
+    {
+        static BenchmarkRegistry inst;
+        return inst;
+    }
+
+    /// @brief 計測結果を記録する。同じ名前の結果は上書きされる
+    void Record(std::string const& name, PerformanceStats const& stats)
+    {
+        auto lock      = std::lock_guard{mtx_};
+        results_[name] = stats;
+    }
+
+    BenchmarkResults Results() const
+    {
+        auto lock = std::lock_guard{mtx_};
+        return results_;
+    }
+
+    /// @brief nameの計測結果を削除する
+    void Erase(std::string const& name)
+    {
+        auto lock = std::lock_guard{mtx_};
+        results_.erase(name);
+    }
+
+    void Clear()
+    {
+        auto lock = std::lock_guard{mtx_};
+        results_.clear();
+    }
+
+    BenchmarkRegistry(BenchmarkRegistry const&)            = delete;
+    BenchmarkRegistry& operator=(BenchmarkRegistry const&) = delete;
+
+private:
+    BenchmarkRegistry() = default;
+
+    mutable std::mutex mtx_{};
+    BenchmarkResults   results_{};
+};
+
+/// @brief 計測結果をBenchmarkRegistryに記録し、そのまま返す
+inline PerformanceStats RecordBenchmark(std::string const& name, PerformanceStats stats)
+{
+    BenchmarkRegistry::Instance().Record(name, stats);
+    return stats;
+}
+
+namespace Inner_ {
+
+inline std::string QuoteJson(std::string const& str)
+{
+    auto ret = std::string{"\""};
+
+    for (auto c : str) {
+        switch (c) {
+        case '"':
+            ret += "\\\"";
+            break;
+        case '\\':
+            ret += "\\\\";
+            break;
+        case '\n':
+            ret += "\\n";
+            break;
+        default:
+            ret += c;
+            break;
+        }
+    }
+
+    return ret + "\"";
+}
+
+inline std::string QuoteCsv(std::string const& str)
+{
+    if (str.find_first_of(",\"\n") == std::string::npos) {
+        return str;
+    }
+
+    auto ret = std::string{"\""};
+    for (auto c : str) {
+        ret += c;
+        if (c == '"') {
+            ret += c;
+        }
+    }
+
+    return ret + "\"";
+}
+
+/// @brief QuoteCsvで出力された1行を、フィールドに分割する
+inline std::vector<std::string> SplitCsv(std::string const& line)
+{
+    auto fields   = std::vector<std::string>{1};
+    auto in_quote = false;
+
+    for (auto i = 0U; i < line.size(); ++i) {
+        auto const c = line[i];
+
+        if (in_quote) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += c;
+                ++i;
+            }
+            else if (c == '"') {
+                in_quote = false;
+            }
+            else {
+                fields.back() += c;
+            }
+        }
+        else if (c == '"') {
+            in_quote = true;
+        }
+        else if (c == ',') {
+            fields.emplace_back();
+        }
+        else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+
+    return fields;
+}
+}  // namespace Inner_
+
+/// @brief 計測結果をJSONで出力する
+inline void WriteJson(std::ostream& os, BenchmarkResults const& results)
+{
+    os << "{\n  \"benchmarks\": [";
+
+    auto first = true;
+    for (auto const& [name, stats] : results) {
+        os << (first ? "\n" : ",\n");
+        first = false;
+
+        os << "    {\"name\": " << Inner_::QuoteJson(name) << ", \"ops_per_sample\": " << stats.ops_per_sample
+           << ", \"min_ns\": " << stats.min_ns << ", \"median_ns\": " << stats.median_ns
+           << ", \"mean_ns\": " << stats.mean_ns << ", \"p90_ns\": " << stats.p90_ns
+           << ", \"p99_ns\": " << stats.p99_ns << ", \"stddev_ns\": " << stats.stddev_ns;
+
+        if (stats.allocations_per_op) {
+            os << ", \"allocations_per_op\": " << *stats.allocations_per_op;
+        }
+
+        os << ", \"samples_ns\": [";
+        for (auto i = 0U; i < stats.samples_ns.size(); ++i) {
+            os << (i == 0 ? "" : ", ") << stats.samples_ns[i];
+        }
+        os << "]}";
+    }
+
+    os << "\n  ]\n}\n";
+}
+
+/// @brief 計測結果のサンプルを「name,sample,ns_per_op」形式のCSVで出力する
+/// @details このCSVはReadCsvでベースラインとして読み込める
+inline void WriteCsv(std::ostream& os, BenchmarkResults const& results)
+{
+    auto const precision = os.precision(10);
+
+    os << "name,sample,ns_per_op\n";
+
+    for (auto const& [name, stats] : results) {
+        auto const quoted = Inner_::QuoteCsv(name);
+
+        for (auto i = 0U; i < stats.samples_ns.size(); ++i) {
+            os << quoted << ',' << i << ',' << stats.samples_ns[i] << '\n';
+        }
+    }
+
+    os.precision(precision);
+}
+
+/// @brief WriteCsvで出力されたCSVを読み込む。不正な行は読み飛ばす
+inline BenchmarkSamples ReadCsv(std::istream& is)
+{
+    auto samples = BenchmarkSamples{};
+    auto line    = std::string{};
+
+    std::getline(is, line);  // ヘッダ
+
+    while (std::getline(is, line)) {
+        auto const fields = Inner_::SplitCsv(line);
+        if (fields.size() != 3) {
+            continue;
+        }
+
+        auto iss = std::istringstream{fields[2]};
+        auto ns  = 0.0;
+        if (iss >> ns) {
+            samples[fields[0]].push_back(ns);
+        }
+    }
+
+    return samples;
+}
+
+/// @brief Mann-Whitney U検定の結果
+struct MannWhitneyResult {
+    double u{0.0};        ///< currentのU統計量
+    double z{0.0};        ///< 正規近似によるz値
+    double p_value{1.0};  ///< 「currentがbaselineより大きい」の片側p値
+};
+
+/// @brief Mann-Whitney U検定(正規近似、同順位補正、連続性補正あり)で、currentがbaselineより大きいかを検定する
+inline MannWhitneyResult MannWhitneyU(std::vector<double> const& baseline, std::vector<double> const& current)
+{
+    auto const n1 = static_cast<double>(current.size());
+    auto const n2 = static_cast<double>(baseline.size());
+
+    if (current.empty() || baseline.empty()) {
+        return MannWhitneyResult{};
+    }
+
+    auto all = std::vector<std::pair<double, bool>>{};  // (値, currentならtrue)
+    all.reserve(current.size() + baseline.size());
+
+    for (auto v : current) {
+        all.emplace_back(v, true);
+    }
+    for (auto v : baseline) {
+        all.emplace_back(v, false);
+    }
+
+    std::sort(all.begin(), all.end(), [](auto const& l, auto const& r) noexcept { return l.first < r.first; });
+
+    auto rank_sum = 0.0;  // currentの順位和
+    auto ties     = 0.0;  // 同順位補正項 Σ(t^3 - t)
+
+    for (auto i = 0U; i < all.size();) {
+        auto j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+
+        auto const rank = (i + 1 + j) / 2.0;  // 同順位には平均順位を与える
+        auto const t    = static_cast<double>(j - i);
+
+        for (auto k = i; k < j; ++k) {
+            if (all[k].second) {
+                rank_sum += rank;
+            }
+        }
+
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    auto const n     = n1 + n2;
+    auto const u     = rank_sum - n1 * (n1 + 1) / 2;
+    auto const mean  = n1 * n2 / 2;
+    auto const sigma = std::sqrt(n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1))));
+
+    auto result = MannWhitneyResult{};
+    result.u    = u;
+
+    if (sigma == 0.0) {
+        return result;
+    }
+
+    result.z       = (u - mean - 0.5) / sigma;
+    result.p_value = 0.5 * std::erfc(result.z / std::sqrt(2.0));
+
+    return result;
+}
+
+/// @brief ベースラインとの比較結果
+struct RegressionReport {
+    std::string name{};
+    double      baseline_median_ns{0.0};
+    double      current_median_ns{0.0};
+    double      p_value{1.0};
+    bool        is_regression{false};  ///< 統計的に有意、かつmin_slowdown以上に遅くなった場合true
+
+    /// @brief 中央値の比(current / baseline)
+    double slowdown() const noexcept
+    {
+        return baseline_median_ns == 0.0 ? 1.0 : current_median_ns / baseline_median_ns;
+    }
+};
+
+/// @brief 両方に存在するベンチマークについて、currentがbaselineより遅くなったかを判定する
+/// @param baseline ベースラインのサンプル
+/// @param current 今回のサンプル
+/// @param alpha 有意水準
+/// @param min_slowdown 中央値の比がこれ以上の場合のみ、退行とみなす(ノイズの除外)
+inline std::vector<RegressionReport> CompareWithBaseline(BenchmarkSamples const& baseline,
+                                                         BenchmarkSamples const& current, double alpha = 0.01,
+                                                         double min_slowdown = 1.05)
+{
+    auto reports = std::vector<RegressionReport>{};
+
+    for (auto const& [name, samples] : current) {
+        auto it = baseline.find(name);
+        if (it == baseline.end() || samples.empty() || it->second.empty()) {
+            continue;
+        }
+
+        auto base = it->second;
+        auto curr = samples;
+        std::sort(base.begin(), base.end());
+        std::sort(curr.begin(), curr.end());
+
+        auto report               = RegressionReport{};
+        report.name               = name;
+        report.baseline_median_ns = Percentile(base, 50.0);
+        report.current_median_ns  = Percentile(curr, 50.0);
+        report.p_value            = MannWhitneyU(base, curr).p_value;
+        report.is_regression      = report.p_value < alpha && report.slowdown() >= min_slowdown;
+
+        reports.push_back(std::move(report));
+    }
+
+    return reports;
+}
+
+/// @brief BenchmarkResultsからサンプルのみを取り出す
+inline BenchmarkSamples ToSamples(BenchmarkResults const& results)
+{
+    auto samples = BenchmarkSamples{};
+
+    for (auto const& [name, stats] : results) {
+        samples[name] = stats.samples_ns;
+    }
+
+    return samples;
+}
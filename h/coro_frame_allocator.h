@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/// @brief 解放されたコルーチンフレームをサイズクラス毎に保持し、次の同じサイズクラスのフレームに再利用するメモリリソース
+/// @details スレッド毎のインスタンス(ThreadLocal())として使うため、排他制御は行わない。
+///          max_frame_sizeを超えるフレームと、保持数がmax_cachedに達したサイズクラスのフレームはグローバルnew/deleteで扱う。
+///          max_align_tを超えるアライメントの要求はstd::bad_allocとなる。
+class FrameRecyclingResource final : public std::pmr::memory_resource {
+public:
+    static constexpr size_t granularity    = 64;    ///< サイズクラスの幅
+    static constexpr size_t max_frame_size = 2048;  ///< これより大きいフレームは再利用しない
+    static constexpr size_t max_cached     = 64;    ///< サイズクラス毎に保持するフレームの最大数
+
+    FrameRecyclingResource() noexcept = default;
+
+    ~FrameRecyclingResource() override
+    {
+        for (auto* node : free_lists_) {
+            while (node != nullptr) {
+                ::operator delete(std::exchange(node, node->next));
+            }
+        }
+    }
+
+    FrameRecyclingResource(FrameRecyclingResource const&)            = delete;
+    FrameRecyclingResource& operator=(FrameRecyclingResource const&) = delete;
+
+    /// @brief 呼び出しスレッドのインスタンス
+    /// @return スレッド終了時にインスタンスが破棄された後(thread_localなオブジェクトのデストラクタ等)はnullptr
+    static FrameRecyclingResource* ThreadLocal() noexcept
+    {
+        struct holder_t {
+            FrameRecyclingResource resource{};
+            ~holder_t() { destroyed = true; }
+        };
+
+        if (destroyed) {
+            return nullptr;
+        }
+
+        thread_local holder_t holder;
+        return &holder.resource;
+    }
+
+private:
+    static constexpr size_t class_count = max_frame_size / granularity;
+
+    static inline thread_local bool destroyed{false};  // トリビアルな型のため、スレッド終了の最後まで参照できる
+
+    struct node_t {
+        node_t* next;
+    };
+
+    node_t* free_lists_[class_count]{};
+    size_t  cached_[class_count]{};
+
+    static constexpr size_t class_of(size_t size) noexcept { return (size - 1) / granularity; }
+
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        if (alignment > alignof(std::max_align_t)) {
+            throw std::bad_alloc{};
+        }
+
+        if (size > max_frame_size) {
+            return ::operator new(size);
+        }
+
+        auto const c = class_of(size);
+        if (auto* node = free_lists_[c]; node != nullptr) {
+            free_lists_[c] = node->next;
+            --cached_[c];
+            return node;
+        }
+
+        return ::operator new((c + 1) * granularity);
+    }
+
+    void do_deallocate(void* mem, size_t size, size_t) noexcept override
+    {
+        if (size > max_frame_size || cached_[class_of(size)] == max_cached) {
+            ::operator delete(mem);
+            return;
+        }
+
+        auto const c   = class_of(size);
+        free_lists_[c] = new (mem) node_t{free_lists_[c]};
+        ++cached_[c];
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override { return this == &other; }
+};
+
+/// @brief コルーチンのpromise_typeの基底クラスとし、コルーチンフレームの確保をstd::pmr::memory_resourceで行う
+/// @details コルーチンの引数が(std::allocator_arg, std::pmr::memory_resource*, ...)で始まる場合、
+///          (メンバ関数の場合はオブジェクトの後に続く場合)、フレームはそのメモリリソースから確保する。
+///          それ以外の場合は、呼び出しスレッドのFrameRecyclingResourceから確保する。
+///          フレームの末尾に確保したメモリリソースを記録し、解放時に使う。
+///          スレッド終了時にFrameRecyclingResourceが破棄された後は、グローバルnew/deleteで確保/解放する。
+struct CoroFrameAllocation {
+    static void* operator new(size_t size) { return allocate(nullptr, size); }
+
+    template <typename... ARGS>
+    static void* operator new(size_t size, std::allocator_arg_t, std::pmr::memory_resource* mr, ARGS const&...)
+    {
+        return allocate(mr, size);
+    }
+
+    template <typename THIS, typename... ARGS>
+    static void* operator new(size_t size, THIS const&, std::allocator_arg_t, std::pmr::memory_resource* mr,
+                              ARGS const&...)
+    {
+        return allocate(mr, size);
+    }
+
+    static void operator delete(void* frame, size_t size) noexcept
+    {
+        auto* mr = *resource_of(frame, size);
+
+        // 記録がnullptrならば、解放するスレッドのFrameRecyclingResourceに戻す
+        if (mr == nullptr && (mr = FrameRecyclingResource::ThreadLocal()) == nullptr) {
+            ::operator delete(frame);  // FrameRecyclingResourceの領域はグローバルnewで確保されている
+            return;
+        }
+
+        mr->deallocate(frame, frame_size(size));
+    }
+
+private:
+    static constexpr size_t resource_offset(size_t size) noexcept
+    {
+        return (size + alignof(std::pmr::memory_resource*) - 1) & ~(alignof(std::pmr::memory_resource*) - 1);
+    }
+
+    static constexpr size_t frame_size(size_t size) noexcept
+    {
+        return resource_offset(size) + sizeof(std::pmr::memory_resource*);
+    }
+
+    static std::pmr::memory_resource** resource_of(void* frame, size_t size) noexcept
+    {
+        return reinterpret_cast<std::pmr::memory_resource**>(static_cast<std::byte*>(frame) + resource_offset(size));
+    }
+
+    static void* allocate(std::pmr::memory_resource* mr, size_t size)
+    {
+        auto* from = mr != nullptr ? mr : FrameRecyclingResource::ThreadLocal();
+        if (from == nullptr) {
+            from = mr = std::pmr::new_delete_resource();  // 解放時もFrameRecyclingResourceに戻さない
+        }
+
+        auto* frame = from->allocate(frame_size(size));
+
+        *resource_of(frame, size) = mr;
+
+        return frame;
+    }
+};
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "nstd_type2str.h"
+#include "spin_lock.h"
+
+/// @brief ロック待ち時間、保持時間のヒストグラムのバケット数
+/// @details バケットiは[2^(i-1), 2^i)[ns]の度数。バケット0は0[ns]、最後のバケットはそれ以上すべて
+inline constexpr size_t lock_histogram_buckets{32};
+
+using LockHistogram = std::array<uint64_t, lock_histogram_buckets>;
+
+/// @brief ロックサイト毎の統計のスナップショット
+struct LockSiteStats {
+    std::string   name{};
+    uint64_t      acquisitions{0};
+    uint64_t      contentions{0};      ///< 最初のtry_lockで獲得できなかった回数
+    uint64_t      spin_iterations{0};  ///< 競合時のtry_lockの再試行回数の合計
+    uint64_t      wait_ns{0};          ///< 競合時の待ち時間の合計
+    LockHistogram wait_histogram{};    ///< 競合時の待ち時間の分布
+    LockHistogram hold_histogram{};    ///< 保持時間の分布(hold_sample_period回に1回のサンプリング)
+
+    /// @brief 競合率
+    double contention_rate() const noexcept
+    {
+        return acquisitions == 0 ? 0.0 : static_cast<double>(contentions) / acquisitions;
+    }
+};
+
+/// @brief log2バケットのヒストグラムのpercent[%]点を含むバケットの上限を返す。度数が0なら0
+template <size_t N>
+uint64_t HistogramPercentile(std::array<uint64_t, N> const& histogram, double percent) noexcept
+{
+    auto total = uint64_t{0};
+    for (auto n : histogram) {
+        total += n;
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    auto const target = static_cast<double>(total) * percent / 100.0;
+    auto       sum    = uint64_t{0};
+
+    for (auto i = 0U; i < histogram.size(); ++i) {
+        sum += histogram[i];
+        if (sum >= target && histogram[i] != 0) {
+            return i == 0 ? 0 : uint64_t{1} << i;
+        }
+    }
+
+    return uint64_t{1} << (histogram.size() - 1);
+}
+
+inline std::ostream& operator<<(std::ostream& os, LockSiteStats const& stats)
+{
+    auto const spins_per_contention
+        = stats.contentions == 0 ? 0.0 : static_cast<double>(stats.spin_iterations) / stats.contentions;
+
+    return os << stats.name << " acquisitions:" << stats.acquisitions << " contention:" << stats.contention_rate()
+              << " spins/contention:" << spins_per_contention
+              << " wait p50:" << HistogramPercentile(stats.wait_histogram, 50)
+              << "ns p99:" << HistogramPercentile(stats.wait_histogram, 99)
+              << "ns hold p50:" << HistogramPercentile(stats.hold_histogram, 50)
+              << "ns p99:" << HistogramPercentile(stats.hold_histogram, 99) << "ns";
+}
+
+namespace Inner_ {
+
+inline size_t HistogramBucket(uint64_t ns) noexcept
+{
+    if (ns == 0) {
+        return 0;
+    }
+
+    auto const bucket = static_cast<size_t>(64 - __builtin_clzll(ns));
+    return bucket < lock_histogram_buckets ? bucket : lock_histogram_buckets - 1;
+}
+
+inline uint64_t NowNs() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace Inner_
+
+/// @brief 名前付きのロックサイトの統計。同じ名前のInstrumentedLockは同じLockSiteに記録する
+class LockSite {
+public:
+    explicit LockSite(std::string name) : name_{std::move(name)} {}
+
+    void RecordAcquisition() noexcept { acquisitions_.fetch_add(1, std::memory_order_relaxed); }
+
+    void RecordContention(uint64_t spins, uint64_t wait_ns) noexcept
+    {
+        contentions_.fetch_add(1, std::memory_order_relaxed);
+        spin_iterations_.fetch_add(spins, std::memory_order_relaxed);
+        wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+        wait_histogram_[Inner_::HistogramBucket(wait_ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordHold(uint64_t hold_ns) noexcept
+    {
+        hold_histogram_[Inner_::HistogramBucket(hold_ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LockSiteStats Snapshot() const
+    {
+        auto stats            = LockSiteStats{};
+        stats.name            = name_;
+        stats.acquisitions    = acquisitions_.load(std::memory_order_relaxed);
+        stats.contentions     = contentions_.load(std::memory_order_relaxed);
+        stats.spin_iterations = spin_iterations_.load(std::memory_order_relaxed);
+        stats.wait_ns         = wait_ns_.load(std::memory_order_relaxed);
+
+        for (auto i = 0U; i < lock_histogram_buckets; ++i) {
+            stats.wait_histogram[i] = wait_histogram_[i].load(std::memory_order_relaxed);
+            stats.hold_histogram[i] = hold_histogram_[i].load(std::memory_order_relaxed);
+        }
+
+        return stats;
+    }
+
+    void Reset() noexcept
+    {
+        acquisitions_.store(0, std::memory_order_relaxed);
+        contentions_.store(0, std::memory_order_relaxed);
+        spin_iterations_.store(0, std::memory_order_relaxed);
+        wait_ns_.store(0, std::memory_order_relaxed);
+
+        for (auto i = 0U; i < lock_histogram_buckets; ++i) {
+            wait_histogram_[i].store(0, std::memory_order_relaxed);
+            hold_histogram_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::string const                                         name_;
+    std::atomic<uint64_t>                                     acquisitions_{0};
+    std::atomic<uint64_t>                                     contentions_{0};
+    std::atomic<uint64_t>                                     spin_iterations_{0};
+    std::atomic<uint64_t>                                     wait_ns_{0};
+    std::array<std::atomic<uint64_t>, lock_histogram_buckets> wait_histogram_{};
+    std::array<std::atomic<uint64_t>, lock_histogram_buckets> hold_histogram_{};
+};
+
+/// @brief LockSiteを名前毎に保持するレジストリ
+class LockProfiler {
+public:
+    static LockProfiler& Instance()
+    {
+        static LockProfiler inst;
+        return inst;
+    }
+
+    /// @brief nameのLockSiteを返す。なければ生成する。返したLockSiteはプロセス終了まで有効
+    LockSite& Site(std::string const& name)
+    {
+        auto lock = std::lock_guard{mtx_};
+
+        auto& site = sites_[name];
+        if (!site) {
+            site = std::make_unique<LockSite>(name);
+        }
+
+        return *site;
+    }
+
+    /// @brief 全LockSiteの統計を名前順に返す
+    std::vector<LockSiteStats> Snapshot() const
+    {
+        auto lock = std::lock_guard{mtx_};
+
+        auto ret = std::vector<LockSiteStats>{};
+        for (auto const& [name, site] : sites_) {
+            ret.push_back(site->Snapshot());
+        }
+
+        return ret;
+    }
+
+    /// @brief 全LockSiteの統計を1行ずつ出力する
+    void Dump(std::ostream& os) const
+    {
+        for (auto const& stats : Snapshot()) {
+            os << stats << '\n';
+        }
+    }
+
+    /// @brief 全LockSiteの統計を0にする。LockSite自体は削除しない
+    void Reset()
+    {
+        auto lock = std::lock_guard{mtx_};
+
+        for (auto& [name, site] : sites_) {
+            site->Reset();
+        }
+    }
+
+    LockProfiler(LockProfiler const&)            = delete;
+    LockProfiler& operator=(LockProfiler const&) = delete;
+
+private:
+    LockProfiler() = default;
+
+    mutable std::mutex                               mtx_{};
+    std::map<std::string, std::unique_ptr<LockSite>> sites_{};
+};
+
+/// @brief LOCKをラップし、獲得回数、競合時のスピン回数と待ち時間、保持時間をLockSiteに記録するロック
+/// @details 競合しない場合のオーバーヘッドは、try_lockとアトミック変数のインクリメントのみであり、
+///          時刻の取得は競合時と、hold_sample_period回に1回の保持時間のサンプリング時に限られる。
+///          LOCKはlock/unlock/try_lockを持たなければならない(SpinLock、std::mutex等)。
+/// @tparam LOCK ラップするロックの型
+template <typename LOCK>
+class InstrumentedLock {
+public:
+    static constexpr uint32_t hold_sample_period = 16;  // 2のべき乗
+    static constexpr uint32_t max_spin           = 100;  // これ以上はLOCK::lockで待つ
+
+    /// @param site 記録先のロックサイト名
+    explicit InstrumentedLock(std::string const& site) : site_{&LockProfiler::Instance().Site(site)} {}
+
+    /// @brief ロックサイト名はLOCKの型名になる
+    InstrumentedLock() : InstrumentedLock{Nstd::Type2Str<LOCK>()} {}
+
+    void lock()
+    {
+        if (!lock_.try_lock()) {
+            lock_contended();
+        }
+
+        acquired();
+    }
+
+    bool try_lock() noexcept
+    {
+        if (!lock_.try_lock()) {
+            return false;
+        }
+
+        acquired();
+        return true;
+    }
+
+    void unlock() noexcept
+    {
+        auto const hold_start = hold_start_ns_;
+        lock_.unlock();
+
+        if (hold_start != 0) {
+            site_->RecordHold(Inner_::NowNs() - hold_start);
+        }
+    }
+
+    InstrumentedLock(InstrumentedLock const&)            = delete;
+    InstrumentedLock& operator=(InstrumentedLock const&) = delete;
+
+private:
+    LOCK      lock_{};
+    LockSite* site_;
+    uint32_t  acquired_count_{0};  // ロック保持スレッドのみがアクセスする
+    uint64_t  hold_start_ns_{0};   // 同上。0ならサンプリングしない
+
+    void lock_contended()
+    {
+        auto const start = Inner_::NowNs();
+        auto       spins = uint64_t{0};
+
+        for (; !lock_.try_lock(); ++spins) {
+            if (spins == max_spin) {
+                lock_.lock();
+                break;
+            }
+            CpuRelax();
+        }
+
+        site_->RecordContention(spins, Inner_::NowNs() - start);
+    }
+
+    void acquired() noexcept
+    {
+        site_->RecordAcquisition();
+        hold_start_ns_ = (++acquired_count_ & (hold_sample_period - 1)) == 0 ? Inner_::NowNs() : 0;
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "spin_lock.h"
+
+namespace Inner_ {
+
+/// @brief McsLockの待ち行列の要素。各待機スレッドは自分のノードのlockedだけをスピンする
+struct alignas(cache_line_size) McsNode {
+    std::atomic<McsNode*> next{nullptr};
+    std::atomic<bool>     locked{false};
+};
+
+/// @brief スレッド毎のMcsNodeのプール
+/// @details ロック毎にノードをアロケーションしないためのもの。
+///          ロックの解放順は任意でよいように、空きノードをスタックで管理する。
+class McsNodePool {
+public:
+    McsNodePool() noexcept
+    {
+        for (auto i = 0U; i < max_nodes; ++i) {
+            free_[i] = &nodes_[i];
+        }
+    }
+
+    McsNode* Acquire() noexcept
+    {
+        assert(free_count_ != 0);  // 同一スレッドが同時に保持できるMcsLockはmax_nodes個まで
+        return free_[--free_count_];
+    }
+
+    void Release(McsNode* node) noexcept { free_[free_count_++] = node; }
+
+    McsNodePool(McsNodePool const&)            = delete;
+    McsNodePool& operator=(McsNodePool const&) = delete;
+
+private:
+    static constexpr size_t max_nodes = 16;
+
+    McsNode  nodes_[max_nodes]{};
+    McsNode* free_[max_nodes]{};
+    size_t   free_count_{max_nodes};
+};
+
+inline thread_local McsNodePool mcs_node_pool;
+}  // namespace Inner_
+
+/// @brief MCS(Mellor-Crummey and Scott)キューロック
+/// @details 待機スレッドは連結リストで並び、それぞれが自分のキャッシュラインのみをスピンするため、
+///          ロック解放時のキャッシュラインの無効化は次のスレッドの1つだけで済む。FIFO順にロックを与える。
+///          SpinLockと同じlock/unlock/try_lockを持つが、unlockはlockしたスレッドで呼び出さなければならない。
+class McsLock {
+public:
+    void lock() noexcept
+    {
+        auto* node = Inner_::mcs_node_pool.Acquire();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+
+        auto* pred = tail_.exchange(node, std::memory_order_acq_rel);
+        if (pred != nullptr) {  // 先行者がいれば、その後ろに並ぶ
+            pred->next.store(node, std::memory_order_release);
+
+            for (auto spin = 0U; node->locked.load(std::memory_order_acquire); ++spin) {
+                if (spin < max_spin) {
+                    CpuRelax();
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        owner_ = node;
+    }
+
+    bool try_lock() noexcept
+    {
+        auto* node = Inner_::mcs_node_pool.Acquire();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+
+        Inner_::McsNode* expected = nullptr;
+        if (tail_.compare_exchange_strong(expected, node, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            owner_ = node;
+            return true;
+        }
+
+        Inner_::mcs_node_pool.Release(node);
+        return false;
+    }
+
+    void unlock() noexcept
+    {
+        auto* node = owner_;
+        auto* next = node->next.load(std::memory_order_acquire);
+
+        if (next == nullptr) {
+            auto* expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+                Inner_::mcs_node_pool.Release(node);  // 待機スレッドはいない
+                return;
+            }
+
+            // tail_の更新後、pred->nextの設定前の後続者を待つ
+            for (auto spin = 0U; (next = node->next.load(std::memory_order_acquire)) == nullptr; ++spin) {
+                if (spin < max_spin) {
+                    CpuRelax();
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        next->locked.store(false, std::memory_order_release);  // 以後、nodeは誰からも参照されない
+        Inner_::mcs_node_pool.Release(node);
+    }
+
+private:
+    static constexpr uint32_t max_spin = 128;
+
+    alignas(cache_line_size) std::atomic<Inner_::McsNode*> tail_{nullptr};  // 待ち行列の末尾
+    Inner_::McsNode* owner_{nullptr};  // ロック保持スレッドのノード。保持スレッドのみがアクセスする
+};
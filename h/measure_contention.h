@@ -0,0 +1,148 @@
+#pragma once
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/// @brief MeasureContentionの計測条件
+struct ContentionOptions {
+    uint32_t threads{1};             ///< 同時に実行するスレッド数
+    uint32_t ops_per_thread{10000};  ///< スレッドあたりの関数の実行回数
+    bool     pin_threads{true};      ///< trueならばスレッドiをコアi % hardware_concurrencyに固定する
+};
+
+/// @brief 複数スレッドから同時に関数を実行した際のスループットと公平性
+struct ContentionStats {
+    uint32_t            threads{0};
+    uint64_t            total_ops{0};
+    double              elapsed_ns{0.0};      ///< 全スレッドの開始から最後のスレッドの終了まで
+    double              ops_per_sec{0.0};     ///< 全スレッド合計のスループット
+    std::vector<double> thread_elapsed_ns{};  ///< スレッド毎の開始から終了まで
+    double              fastest_ns{0.0};      ///< 最も早く終わったスレッドの所要時間
+    double              slowest_ns{0.0};      ///< 最も遅く終わったスレッドの所要時間
+
+    /// @brief 最速スレッドと最遅スレッドの差を最遅スレッドの所要時間で割った値。0なら完全に公平
+    double unfairness() const noexcept { return slowest_ns == 0.0 ? 0.0 : (slowest_ns - fastest_ns) / slowest_ns; }
+};
+
+inline std::ostream& operator<<(std::ostream& os, ContentionStats const& stats)
+{
+    return os << "threads:" << stats.threads << " ops/sec:" << stats.ops_per_sec
+              << " fastest:" << stats.fastest_ns / 1'000'000 << "ms slowest:" << stats.slowest_ns / 1'000'000
+              << "ms unfairness:" << stats.unfairness();
+}
+
+/// @brief ハードウェアスレッド数。取得できない場合は1
+inline uint32_t HardwareThreads() noexcept { return std::max(std::thread::hardware_concurrency(), 1U); }
+
+namespace Inner_ {
+
+/// @brief スレッドをcpu番目のコアに固定する。固定できない環境では何もしない
+inline void PinThread(std::thread& th, uint32_t cpu) noexcept
+{
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu % HardwareThreads(), &cpuset);
+
+    pthread_setaffinity_np(th.native_handle(), sizeof(cpuset), &cpuset);  // 失敗しても計測は続ける
+#else
+    static_cast<void>(th);
+    static_cast<void>(cpu);
+#endif
+}
+}  // namespace Inner_
+
+/// @brief options.threads個のスレッドから関数fを同時にoptions.ops_per_thread回ずつ実行し、
+///        スループットとスレッド間の公平性を計測する。
+/// @tparam FUNC 実行する関数オブジェクトの型。複数のスレッドから同時に呼び出される
+/// @param options 計測条件
+/// @param f 実行する関数オブジェクト
+template <typename FUNC>
+ContentionStats MeasureContention(ContentionOptions const& options, FUNC&& f)
+{
+    using clock = std::chrono::steady_clock;
+
+    auto const threads = std::max(options.threads, 1U);
+
+    auto ready   = std::atomic<uint32_t>{0};
+    auto go      = std::atomic<bool>{false};
+    auto elapsed = std::vector<double>(threads);
+    auto start   = clock::time_point{};
+
+    auto worker = [&](uint32_t index) {
+        ready.fetch_add(1, std::memory_order_release);
+        while (!go.load(std::memory_order_acquire)) {  // 全スレッドを同時に開始させる
+            std::this_thread::yield();
+        }
+
+        for (auto i = 0U; i < options.ops_per_thread; ++i) {
+            f();
+        }
+
+        elapsed[index] = std::chrono::duration<double, std::nano>{clock::now() - start}.count();
+    };
+
+    auto ths = std::vector<std::thread>{};
+    ths.reserve(threads);
+
+    for (auto i = 0U; i < threads; ++i) {
+        ths.emplace_back(worker, i);
+        if (options.pin_threads) {
+            Inner_::PinThread(ths.back(), i);
+        }
+    }
+
+    while (ready.load(std::memory_order_acquire) != threads) {
+        std::this_thread::yield();
+    }
+
+    start = clock::now();
+    go.store(true, std::memory_order_release);
+
+    for (auto& th : ths) {
+        th.join();
+    }
+
+    auto stats              = ContentionStats{};
+    stats.threads           = threads;
+    stats.total_ops         = static_cast<uint64_t>(threads) * options.ops_per_thread;
+    stats.fastest_ns        = *std::min_element(elapsed.cbegin(), elapsed.cend());
+    stats.slowest_ns        = *std::max_element(elapsed.cbegin(), elapsed.cend());
+    stats.elapsed_ns        = stats.slowest_ns;
+    stats.ops_per_sec       = stats.elapsed_ns == 0.0 ? 0.0 : stats.total_ops * 1e9 / stats.elapsed_ns;
+    stats.thread_elapsed_ns = std::move(elapsed);
+
+    return stats;
+}
+
+/// @brief スレッド数を1, 2, 4, ...と倍にしながらmax_threadsまで変えてMeasureContentionを実行する
+/// @param ops_per_thread スレッドあたりの関数の実行回数
+/// @param f 実行する関数オブジェクト
+/// @param max_threads 最大スレッド数(デフォルトはハードウェアスレッド数)
+/// @return スレッド数毎の計測結果
+template <typename FUNC>
+std::vector<ContentionStats> SweepContention(uint32_t ops_per_thread, FUNC&& f,
+                                             uint32_t max_threads = HardwareThreads())
+{
+    auto result = std::vector<ContentionStats>{};
+
+    for (auto threads = 1U;; threads = std::min(threads * 2, max_threads)) {
+        result.push_back(MeasureContention(ContentionOptions{threads, ops_per_thread, true}, f));
+
+        if (threads >= max_threads) {
+            break;
+        }
+    }
+
+    return result;
+}
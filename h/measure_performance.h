@@ -1,5 +1,17 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "perf_counter.h"
 
 // @@@ sample begin 0:0
 
@@ -11,14 +23,214 @@
 template <typename FUNC>
 std::chrono::milliseconds MeasurePerformance(uint32_t count, FUNC f)
 {
-    auto const start = std::chrono::system_clock::now();
+    auto const start = std::chrono::steady_clock::now();  // system_clockは時刻補正の影響を受けるため使わない
 
     for (auto i = 0U; i < count; ++i) {
         f();
     }
 
-    auto const stop = std::chrono::system_clock::now();
+    auto const stop = std::chrono::steady_clock::now();
 
     return std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
 }
 // @@@ sample end
+
+/// @brief valueを計算済みの値としてコンパイラに認識させ、その計算を最適化で削除させない
+/// @details valueはレジスタかメモリに実体化されたものとして扱われる
+template <typename T>
+inline void DoNotOptimize(T const& value) noexcept
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// @brief valueが読み書きされたものとしてコンパイラに認識させる
+template <typename T>
+inline void DoNotOptimize(T& value) noexcept
+{
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#else
+    asm volatile("" : "+m,r"(value) : : "memory");
+#endif
+}
+
+/// @brief 未完了のメモリへの書き込みを、この位置までに完了させる(コンパイラに対するバリア)
+inline void ClobberMemory() noexcept { asm volatile("" : : : "memory"); }
+
+namespace Inner_ {
+
+/// @brief fを呼び出し、戻り値がある場合はそれをDoNotOptimizeに渡す(戻り値の計算を削除させない)
+template <typename FUNC>
+inline void InvokeAndSink(FUNC& f)
+{
+    if constexpr (std::is_void_v<std::invoke_result_t<FUNC&>>) {
+        f();
+    }
+    else {
+        DoNotOptimize(f());
+    }
+}
+}  // namespace Inner_
+
+/// @brief MeasurePerformanceStatsの計測条件
+struct MeasureOptions {
+    uint32_t warmup{100};           ///< 計測前に実行し、結果を捨てる回数
+    uint32_t samples{50};           ///< 採取するサンプル数
+    uint32_t ops_per_sample{1000};  ///< 1サンプルあたりの関数の実行回数
+    bool     perf_counters{false};  ///< trueならば計測区間のperf_eventカウンタを取得する
+};
+
+/// @brief 1オペレーションあたりの実行時間の統計値。単位はすべてナノ秒
+struct PerformanceStats {
+    uint32_t            ops_per_sample{0};
+    double              min_ns{0.0};
+    double              median_ns{0.0};
+    double              mean_ns{0.0};
+    double              p90_ns{0.0};
+    double              p99_ns{0.0};
+    double              stddev_ns{0.0};
+    std::vector<double> samples_ns{};  ///< サンプル毎の1オペレーションあたりの実行時間(昇順)
+
+    /// 1オペレーションあたりのカウンタ値。MeasureOptions::perf_countersがfalseか、
+    /// カーネルがカウンタを許可しない場合はstd::nullopt
+    std::optional<PerfCounterValues> counters_per_op{};
+
+    /// 1オペレーションあたりのoperator newの呼び出し回数。allocation_counter.cppがリンクされていない場合はstd::nullopt
+    std::optional<double> allocations_per_op{};
+};
+
+/// @brief 昇順にソートされたサンプルのパーセンタイル値を線形補間で求める
+/// @param sorted 昇順にソートされたサンプル(空であってはならない)
+/// @param percent 0から100までのパーセント
+inline double Percentile(std::vector<double> const& sorted, double percent) noexcept
+{
+    assert(!sorted.empty());
+
+    auto const pos   = (sorted.size() - 1) * std::clamp(percent, 0.0, 100.0) / 100.0;
+    auto const lower = static_cast<size_t>(pos);
+    auto const upper = std::min(lower + 1, sorted.size() - 1);
+
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (pos - lower);
+}
+
+/// @brief サンプル毎の1オペレーションあたりの実行時間から統計値を求める
+/// @param samples_ns サンプル毎の1オペレーションあたりの実行時間[ns]
+/// @param ops_per_sample 1サンプルあたりの関数の実行回数
+inline PerformanceStats CalcPerformanceStats(std::vector<double> samples_ns, uint32_t ops_per_sample)
+{
+    auto stats           = PerformanceStats{};
+    stats.ops_per_sample = ops_per_sample;
+
+    if (samples_ns.empty()) {
+        return stats;
+    }
+
+    std::sort(samples_ns.begin(), samples_ns.end());
+
+    auto const n = static_cast<double>(samples_ns.size());
+
+    stats.min_ns    = samples_ns.front();
+    stats.median_ns = Percentile(samples_ns, 50.0);
+    stats.p90_ns    = Percentile(samples_ns, 90.0);
+    stats.p99_ns    = Percentile(samples_ns, 99.0);
+    stats.mean_ns   = std::accumulate(samples_ns.cbegin(), samples_ns.cend(), 0.0) / n;
+
+    auto const sq_sum = std::accumulate(samples_ns.cbegin(), samples_ns.cend(), 0.0,
+                                        [mean = stats.mean_ns](double sum, double s) noexcept {
+                                            return sum + (s - mean) * (s - mean);
+                                        });
+
+    stats.stddev_ns  = samples_ns.size() > 1 ? std::sqrt(sq_sum / (n - 1)) : 0.0;
+    stats.samples_ns = std::move(samples_ns);
+
+    return stats;
+}
+
+/// @brief 統計値を「min/median/mean/p90/p99/stddev」の形式で出力する
+inline std::ostream& operator<<(std::ostream& os, PerformanceStats const& stats)
+{
+    os << "min:" << stats.min_ns << "ns median:" << stats.median_ns << "ns mean:" << stats.mean_ns
+       << "ns p90:" << stats.p90_ns << "ns p99:" << stats.p99_ns << "ns stddev:" << stats.stddev_ns << "ns";
+
+    if (stats.allocations_per_op) {
+        os << " allocs/op:" << *stats.allocations_per_op;
+    }
+
+    if (auto const& c = stats.counters_per_op; c) {
+        auto put = [&os](char const* name, std::optional<double> const& v) {
+            if (v) {
+                os << " " << name << ":" << *v;
+            }
+        };
+        put("cycles/op", c->cycles);
+        put("instructions/op", c->instructions);
+        put("IPC", c->ipc());
+        put("cache-misses/op", c->cache_misses);
+        put("branch-misses/op", c->branch_misses);
+        put("context-switches/op", c->context_switches);
+    }
+
+    return os;
+}
+
+/// @brief 関数fをoptions.warmup回実行した後、options.ops_per_sample回の実行をoptions.samples回計測する。
+/// @details fが戻り値を返す場合、その戻り値は毎回DoNotOptimizeに渡されるため、fの処理は最適化で削除されない
+/// @tparam FUNC 実行する関数オブジェクトの型
+/// @param options 計測条件
+/// @param f 実行する関数オブジェクト
+/// @return 1オペレーションあたりの実行時間の統計値
+template <typename FUNC>
+PerformanceStats MeasurePerformanceStats(MeasureOptions const& options, FUNC&& f)
+{
+    using clock = std::chrono::steady_clock;
+    static_assert(clock::is_steady);
+
+    auto const ops_per_sample = std::max(options.ops_per_sample, 1U);
+
+    for (auto i = 0U; i < options.warmup; ++i) {
+        Inner_::InvokeAndSink(f);
+    }
+
+    auto samples_ns = std::vector<double>{};
+    samples_ns.reserve(options.samples);
+
+    auto counters = std::optional<PerfCounters>{};
+    if (options.perf_counters) {
+        counters.emplace();
+        counters->start();
+    }
+
+    auto const allocation = AllocationBudget{};
+
+    for (auto s = 0U; s < options.samples; ++s) {
+        auto const start = clock::now();
+
+        for (auto i = 0U; i < ops_per_sample; ++i) {
+            Inner_::InvokeAndSink(f);
+        }
+        ClobberMemory();
+
+        auto const stop = clock::now();
+
+        samples_ns.push_back(std::chrono::duration<double, std::nano>{stop - start}.count() / ops_per_sample);
+    }
+
+    // 統計値の計算(ソート等)を計測に含めないよう、計算の前にカウンタを止める
+    if (counters) {
+        counters->stop();
+    }
+    auto const allocations = allocation.allocations();
+
+    auto stats = CalcPerformanceStats(std::move(samples_ns), ops_per_sample);
+
+    if (IsAllocationCounterInstalled() && options.samples > 0) {
+        stats.allocations_per_op = static_cast<double>(allocations) / options.samples / ops_per_sample;
+    }
+
+    if (counters && counters->is_available() && options.samples > 0) {
+        stats.counters_per_op = counters->read();
+        *stats.counters_per_op /= static_cast<double>(options.samples) * ops_per_sample;
+    }
+
+    return stats;
+}
@@ -0,0 +1,246 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "coro_frame_allocator.h"
+
+namespace Nstd {
+
+template <typename T>
+class Generator;
+
+/// @brief co_yield ElementsOf{generator}とすることで、generatorの全要素の生成を委譲する
+/// @details g++ 12では、co_yieldのオペランドを集成体初期化するとムーブを経ずに複製されるため、コンストラクタを持たせる
+template <typename T>
+struct ElementsOf {
+    explicit ElementsOf(Generator<T>&& gen) noexcept : generator{std::move(gen)} {}
+
+    Generator<T> generator;  ///< 未開始のGenerator
+};
+
+/// @brief co_yieldした値をコピーせず、コルーチンフレーム内の値への参照として消費者に渡すジェネレータ
+/// @details co_yieldされたオブジェクトは、コルーチンが次に再開されるまで生存するため(左辺値はフレーム内の変数、
+///          右辺値はco_yieldを含む完全式の終わりまで生存する一時オブジェクト)、
+///          promise_typeはそのアドレスのみを保持する。
+///          current_value()はその参照を返す。take_value()は右辺値としてco_yieldされた値をムーブで取り出し、
+///          左辺値としてco_yieldされた値はコピーする(コルーチン側の変数を壊さない)。
+///          コルーチン内の例外は、move_next()から再送出する。
+///          begin()/end()はiterator/sentinelを返すため、範囲for文やstd::ranges::input_rangeとして使える。
+///
+///          co_yield ElementsOf{inner}は、await_suspendがinnerのハンドルを返す対称転送によりinnerに制御を移し、
+///          最も外側のGenerator(root)に最も内側の実行中のコルーチン(leaf)を記録する。
+///          move_next()はleafを直接再開し、innerの終了時はfinal_suspendから呼び出し元へ対称転送する。
+///          そのため、再帰的な委譲の深さによらず、1要素当たりのコストは(償却)O(1)でありスタックも伸びない。
+template <typename T>
+class Generator {
+public:
+    static_assert(!std::is_reference_v<T>, "T must be an object type");
+
+    /// @brief コルーチンのライフサイクルを管理する構造体
+    struct promise_type : CoroFrameAllocation {
+        T*                                  value{nullptr};      ///< (rootのみ)co_yieldされた値
+        bool                                movable{false};      ///< (rootのみ)valueが右辺値の場合true
+        std::exception_ptr                  exception{nullptr};  ///< コルーチン内で発生した例外
+        promise_type*                       root{this};          ///< 最も外側のGeneratorのpromise
+        std::coroutine_handle<promise_type> leaf{};              ///< (rootのみ)次に再開するコルーチン
+        std::coroutine_handle<promise_type> parent{};            ///< ElementsOfで委譲した委譲元
+        std::coroutine_handle<promise_type> inner{};             ///< ElementsOfで委譲中の委譲先。所有する
+
+        ~promise_type()
+        {
+            if (inner) {  // 委譲中に破棄された
+                inner.destroy();
+            }
+        }
+
+        Generator get_return_object() noexcept
+        {
+            leaf = std::coroutine_handle<promise_type>::from_promise(*this);
+            return Generator{leaf};
+        }
+
+        /// @brief 終了時、委譲元があればそこへ対称転送する
+        struct final_awaiter {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                auto& p = h.promise();
+                if (!p.parent) {
+                    return std::noop_coroutine();  // move_next()に戻る
+                }
+
+                p.root->leaf = p.parent;
+                return p.parent;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        /// @brief 委譲先の最初の要素まで対称転送し、委譲先の終了後に再開される
+        /// @details 委譲先はpromise_type::innerが所有し、委譲先の終了後にawait_resumeで破棄する。
+        struct delegate_awaiter {
+            promise_type* outer;
+
+            bool await_ready() noexcept { return !outer->inner || outer->inner.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                auto& p  = outer->inner.promise();
+                p.root   = outer->root;
+                p.parent = h;
+
+                return outer->root->leaf = outer->inner;
+            }
+
+            void await_resume()
+            {
+                auto const inner = std::exchange(outer->inner, nullptr);
+                if (!inner) {
+                    return;
+                }
+
+                auto e = std::exchange(inner.promise().exception, nullptr);
+                inner.destroy();
+
+                if (e) {  // 委譲元に伝播させる
+                    std::rethrow_exception(e);
+                }
+            }
+        };
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        final_awaiter       final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(T const& v) noexcept
+        {
+            root->value   = const_cast<T*>(std::addressof(v));  // movable == falseの場合、変更しない
+            root->movable = false;
+            return {};
+        }
+
+        std::suspend_always yield_value(T&& v) noexcept
+        {
+            root->value   = std::addressof(v);
+            root->movable = true;
+            return {};
+        }
+
+        delegate_awaiter yield_value(ElementsOf<T>&& elements) noexcept
+        {
+            inner = std::exchange(elements.generator.coro_, nullptr);
+            return {this};
+        }
+
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+        void return_void() noexcept {}
+    };
+
+    /// @brief Generatorの終端を表す番兵。iteratorとの比較でコルーチンの終了を判定する
+    struct sentinel {};
+
+    /// @brief co_yieldされた値を順に参照する入力イテレータ。インクリメントでコルーチンを再開する
+    class iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using difference_type  = std::ptrdiff_t;
+        using value_type       = std::remove_cv_t<T>;
+
+        iterator() noexcept = default;
+        explicit iterator(Generator& gen) noexcept : gen_{&gen} {}
+
+        T const& operator*() const noexcept { return gen_->current_value(); }
+
+        iterator& operator++()
+        {
+            gen_->move_next();
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto prev = *this;  // 入力イテレータのため、prevも再開後の値を指す
+            ++*this;
+            return prev;
+        }
+
+        /// @brief デフォルト構築されたイテレータは終端とみなす
+        friend bool operator==(iterator const& it, sentinel) noexcept
+        {
+            return it.gen_ == nullptr || it.gen_->done();
+        }
+
+    private:
+        Generator* gen_{nullptr};
+    };
+
+    explicit Generator(std::coroutine_handle<promise_type> h) noexcept : coro_{h} {}
+    Generator(Generator&& other) noexcept : coro_{std::exchange(other.coro_, nullptr)} {}
+
+    Generator& operator=(Generator&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            coro_ = std::exchange(other.coro_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Generator() { destroy(); }
+
+    /// @brief コルーチンを再開し、次の値を生成する
+    /// @return 次の値が生成された場合は true、終了した場合は false
+    bool move_next()
+    {
+        if (!coro_ || coro_.done()) {
+            return false;
+        }
+
+        coro_.promise().leaf.resume();
+
+        if (auto& e = coro_.promise().exception; e) {
+            std::rethrow_exception(std::exchange(e, nullptr));
+        }
+
+        return !coro_.done();
+    }
+
+    /// @brief 現在の値への参照。コルーチンが次に再開されるまで有効
+    T const& current_value() const noexcept { return *coro_.promise().value; }
+
+    /// @brief 現在の値を取り出す。右辺値としてco_yieldされた値はムーブし、それ以外はコピーする
+    T take_value()
+    {
+        auto& p = coro_.promise();
+
+        return p.movable ? std::move(*p.value) : T(*p.value);  // {}では初期化子リストのコンストラクタが選ばれ得る
+    }
+
+    /// @brief コルーチンを最初のco_yieldまで進め、その値を指すイテレータを返す。1回のみ呼び出せる
+    iterator begin()
+    {
+        move_next();
+        return iterator{*this};
+    }
+
+    sentinel end() const noexcept { return {}; }
+
+    /// @brief コルーチンが終了している場合true
+    bool done() const noexcept { return !coro_ || coro_.done(); }
+
+private:
+    std::coroutine_handle<promise_type> coro_;
+
+    void destroy() noexcept
+    {
+        if (coro_) {
+            coro_.destroy();
+        }
+    }
+};
+}  // namespace Nstd
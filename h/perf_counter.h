@@ -0,0 +1,172 @@
+#pragma once
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+/// @brief perf_event_openで取得したカウンタ値。カーネルが許可しなかったカウンタはstd::nullopt
+struct PerfCounterValues {
+    std::optional<double> cycles{};
+    std::optional<double> instructions{};
+    std::optional<double> cache_misses{};
+    std::optional<double> branch_misses{};
+    std::optional<double> context_switches{};
+
+    /// @brief 1サイクルあたりの命令数(Instructions Per Cycle)
+    std::optional<double> ipc() const noexcept
+    {
+        if (!cycles || !instructions || *cycles == 0.0) {
+            return std::nullopt;
+        }
+        return *instructions / *cycles;
+    }
+
+    /// @brief すべてのカウンタ値をdivisorで割る(1オペレーションあたりの値への変換)
+    PerfCounterValues& operator/=(double divisor) noexcept
+    {
+        for (auto* v : {&cycles, &instructions, &cache_misses, &branch_misses, &context_switches}) {
+            if (*v) {
+                **v /= divisor;
+            }
+        }
+        return *this;
+    }
+};
+
+/// @brief perf_event_openによるカウンタ群。start()からstop()までの区間のカウンタ値を取得する
+/// @details perf_event_paranoid等によりカウンタのオープンが許可されない場合、
+///          そのカウンタは無効となり、read()の該当値はstd::nulloptとなる
+class PerfCounters {
+public:
+    PerfCounters() noexcept
+    {
+#ifdef __linux__
+        fds_[cycles]           = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true);
+        fds_[instructions]     = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true);
+        fds_[cache_misses]     = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, true);
+        fds_[branch_misses]    = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, true);
+        fds_[context_switches] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, false);
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (auto fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(PerfCounters const&)            = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    /// @brief 1つでもカウンタが有効であればtrue
+    bool is_available() const noexcept
+    {
+        for (auto fd : fds_) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief カウンタをリセットし、計測を開始する
+    void start() noexcept
+    {
+#ifdef __linux__
+        ioctl_all(PERF_EVENT_IOC_RESET);
+        ioctl_all(PERF_EVENT_IOC_ENABLE);
+#endif
+    }
+
+    /// @brief 計測を停止する
+    void stop() noexcept
+    {
+#ifdef __linux__
+        ioctl_all(PERF_EVENT_IOC_DISABLE);
+#endif
+    }
+
+    /// @brief start()からstop()までのカウンタ値を返す。多重化された場合は実行時間の比率で補正する
+    PerfCounterValues read() const noexcept
+    {
+        auto values = PerfCounterValues{};
+
+        values.cycles           = read(fds_[cycles]);
+        values.instructions     = read(fds_[instructions]);
+        values.cache_misses     = read(fds_[cache_misses]);
+        values.branch_misses    = read(fds_[branch_misses]);
+        values.context_switches = read(fds_[context_switches]);
+
+        return values;
+    }
+
+private:
+    enum { cycles, instructions, cache_misses, branch_misses, context_switches, counter_max };
+    std::array<int, counter_max> fds_{-1, -1, -1, -1, -1};
+
+#ifdef __linux__
+    static int open(uint32_t type, uint64_t config, bool user_only) noexcept
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.exclude_kernel = user_only ? 1 : 0;  // perf_event_paranoid >= 2でもユーザ空間は計測できる
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // 呼び出しスレッドのみ、全CPUを対象とする
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static std::optional<double> read(int fd) noexcept
+    {
+        if (fd < 0) {
+            return std::nullopt;
+        }
+
+        struct {
+            uint64_t value;
+            uint64_t time_enabled;
+            uint64_t time_running;
+        } data{};
+
+        if (::read(fd, &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            return std::nullopt;
+        }
+
+        if (data.time_running == 0) {
+            return data.time_enabled == 0 ? std::optional<double>{0.0} : std::nullopt;  // 一度も計測されていない
+        }
+
+        return static_cast<double>(data.value) * data.time_enabled / data.time_running;
+    }
+
+    void ioctl_all(unsigned long request) noexcept
+    {
+        for (auto fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, request, 0);
+            }
+        }
+    }
+#else
+    static std::optional<double> read(int) noexcept { return std::nullopt; }
+#endif
+};
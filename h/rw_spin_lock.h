@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "spin_lock.h"
+
+/// @brief 書き込み優先のリーダーライタースピンロック
+/// @details lock/unlock/try_lockで排他ロック、lock_shared/unlock_shared/try_lock_sharedで共有ロックを行うため、
+///          std::lock_guard、std::unique_lock、std::shared_lockで使用できる。
+///          書き込み待ちのスレッドがいる間は新たな共有ロックを与えないため、読み込みが多くても書き込みは飢餓しない。
+///          状態は1つのアトミック変数で表し、隣接するデータとの偽共有を避けるためキャッシュラインに整列する。
+class alignas(cache_line_size) RwSpinLock {
+public:
+    void lock() noexcept
+    {
+        for (auto backoff = 1U;;) {
+            auto state = state_.load(std::memory_order_relaxed);
+
+            if ((state & ~writer_waiting) == 0) {  // 読み込み中、書き込み中のスレッドはいない
+                if (state_.compare_exchange_weak(state, writer_locked, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+
+            if ((state & writer_waiting) == 0) {  // 後続の共有ロックを止める
+                state_.fetch_or(writer_waiting, std::memory_order_relaxed);
+            }
+
+            Inner_::Backoff(backoff);
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        auto state = state_.load(std::memory_order_relaxed);
+
+        return (state & ~writer_waiting) == 0
+               && state_.compare_exchange_strong(state, writer_locked, std::memory_order_acquire,
+                                                 std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept
+    {
+        state_.fetch_and(~writer_locked, std::memory_order_release);  // 他の書き込み待ちのフラグは残す
+    }
+
+    void lock_shared() noexcept
+    {
+        for (auto backoff = 1U; !try_lock_shared();) {
+            Inner_::Backoff(backoff);
+        }
+    }
+
+    bool try_lock_shared() noexcept
+    {
+        auto state = state_.load(std::memory_order_relaxed);
+
+        while ((state & (writer_locked | writer_waiting)) == 0) {
+            if (state_.compare_exchange_weak(state, state + reader, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void unlock_shared() noexcept { state_.fetch_sub(reader, std::memory_order_release); }
+
+private:
+    static constexpr uint32_t writer_locked  = 1U << 0;
+    static constexpr uint32_t writer_waiting = 1U << 1;
+    static constexpr uint32_t reader         = 1U << 2;  // 共有ロック数の単位
+
+    std::atomic<uint32_t> state_{0};
+};
@@ -1,18 +1,75 @@
 #pragma once
 
-// @@@ sample begin 0:0
-
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/// @brief 偽共有を避けるためのアライメント
+inline constexpr size_t cache_line_size{64};
+
+/// @brief スピン待ち中であることをCPUに伝える
+/// @details x86ではpause命令により、同一コアの他のハードウェアスレッドへ実行資源を譲り、
+///          スピンループ脱出時のメモリオーダー違反によるパイプラインのフラッシュを避ける
+inline void CpuRelax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+namespace Inner_ {
+
+/// @brief 上限付きの指数バックオフ。上限に達した後はスレッドを切り替える
+/// @param backoff 現在のバックオフ値。初期値は1で、呼び出し毎に倍になる
+inline void Backoff(uint32_t& backoff) noexcept
+{
+    constexpr uint32_t max_backoff = 1024;
+
+    if (backoff < max_backoff) {
+        for (auto i = 0U; i < backoff; ++i) {
+            CpuRelax();
+        }
+        backoff *= 2;
+    }
+    else {
+        std::this_thread::yield();  // ロック保持スレッドがプリエンプトされている可能性が高い
+    }
+}
+}  // namespace Inner_
+
+// @@@ sample begin 0:0
 
 class SpinLock {
 public:
     void lock() noexcept
     {
+        auto backoff = 1U;
+
+        // test-and-test-and-set
+        // exchangeは値が変わらなくてもキャッシュラインの所有権を要求するため、
+        // 待機中は書き込みを伴わないloadでスピンし、解放が見えた時だけexchangeする
         while (state_.exchange(state::locked, std::memory_order_acquire) == state::locked) {
-            ;  // busy wait
+            while (state_.load(std::memory_order_relaxed) == state::locked) {
+                Inner_::Backoff(backoff);  // 上限付きの指数バックオフ
+            }
         }
     }
 
+    bool try_lock() noexcept
+    {
+        return state_.load(std::memory_order_relaxed) == state::unlocked
+               && state_.exchange(state::locked, std::memory_order_acquire) == state::unlocked;
+    }
+
     void unlock() noexcept { state_.store(state::unlocked, std::memory_order_release); }
 
 private:
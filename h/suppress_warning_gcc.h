@@ -59,6 +59,7 @@
 #define SUPPRESS_WARN_GCC_FALLTHROUGH _Pragma("GCC diagnostic ignored \"-Wimplicit-fallthrough\"")
 #define SUPPRESS_WARN_GCC_LOCAL_RETURN _Pragma("GCC diagnostic ignored \"-Wreturn-local-addr\"")
 #define SUPPRESS_WARN_GCC_MISSING_FIELD_INIT _Pragma("GCC diagnostic ignored \"-Wmissing-field-initializers\"")
+#define SUPPRESS_WARN_GCC_MISMATCHED_NEW_DELETE _Pragma("GCC diagnostic ignored \"-Wmismatched-new-delete\"")
 #define SUPPRESS_WARN_GCC_NON_NULL_COMP _Pragma("GCC diagnostic ignored \"-Wnonnull-compare\"")
 #define SUPPRESS_WARN_GCC_NOT_EFF_CPP _Pragma("GCC diagnostic ignored \"-Weffc++\"")
 #define SUPPRESS_WARN_GCC_OVERFLOW _Pragma("GCC diagnostic ignored \"-Woverflow\"")
@@ -129,6 +130,7 @@
 #define SUPPRESS_WARN_GCC_TYPE_LIMITS
 #define SUPPRESS_WARN_GCC_LOCAL_RETURN
 #define SUPPRESS_WARN_GCC_MISSING_FIELD_INIT
+#define SUPPRESS_WARN_GCC_MISMATCHED_NEW_DELETE
 #define SUPPRESS_WARN_GCC_NARROWING
 #define SUPPRESS_WARN_GCC_NON_NULL_COMP
 #define SUPPRESS_WARN_GCC_NOT_EFF_CPP
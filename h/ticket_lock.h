@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "spin_lock.h"
+
+/// @brief FIFO順にロックを与える公平なスピンロック
+/// @details lockを呼び出した順に番号札(チケット)を取り、serving_が自分の番号になるまで待つ。
+///          SpinLockと同じlock/unlock/try_lockを持つため、std::lock_guard等で使用できる。
+///          待機中のスレッドがプリエンプトされると後続すべてが待たされるため、
+///          スレッド数がコア数を超える環境には向かない。
+class TicketLock {
+public:
+    void lock() noexcept
+    {
+        auto const ticket = next_.fetch_add(1, std::memory_order_relaxed);
+
+        for (auto spin = 0U;; ++spin) {
+            auto const serving = serving_.load(std::memory_order_acquire);
+            if (serving == ticket) {
+                return;
+            }
+
+            if (spin < max_spin) {
+                for (auto i = ticket - serving; i != 0; --i) {  // 順番が遠いほど長く待つ(比例バックオフ)
+                    CpuRelax();
+                }
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        auto serving = serving_.load(std::memory_order_acquire);
+        return next_.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept
+    {
+        // serving_を書き込むのはロック保持スレッドのみのため、fetch_addは不要
+        serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// @brief 次に発行する番号札。lockを呼び出したスレッド数の観測(テスト等)に使う
+    uint32_t next_ticket() const noexcept { return next_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr uint32_t max_spin = 128;
+
+    alignas(cache_line_size) std::atomic<uint32_t> next_{0};     // 次に発行する番号札
+    alignas(cache_line_size) std::atomic<uint32_t> serving_{0};  // ロックを保持できる番号札
+};
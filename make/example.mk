@@ -16,10 +16,12 @@ WARN:=-Wall -Wextra
 
 CPP_VER ?= c++20
 
-CCFLAGS:=-std=$(CPP_VER) $(WARN) -Weffc++ $(WARN_ERROR) $(SUPPRESS_WARN) -g $(SANITIZER) \
+OPTIMIZE ?=
+
+CCFLAGS:=-std=$(CPP_VER) $(WARN) -Weffc++ $(WARN_ERROR) $(SUPPRESS_WARN) -g $(OPTIMIZE) $(SANITIZER) \
 	     $(CCFLAGS_ADD) $(COVERAGE) -D_GLIBCXX_USE_CXX11_ABI=0
 
-CCFLAGS_C:=-std=c99 $(WARN) $(WARN_ERROR) $(SUPPRESS_WARN) -g $(SANITIZER) \
+CCFLAGS_C:=-std=c99 $(WARN) $(WARN_ERROR) $(SUPPRESS_WARN) -g $(OPTIMIZE) $(SANITIZER) \
 	     $(CCFLAGS_ADD) $(COVERAGE) -D_GLIBCXX_USE_CXX11_ABI=0
 
 ifdef SRCS
@@ -72,8 +74,11 @@ $(D)%.d : %.cpp
 $(D)%.d : %.c
 	$(CC) -I$(SHARED)h -I../h -E -MM -w $< | sed -e 's@^\([^ ]\)@$$(O)\1@g' > $@
 
+UT_ENV ?=
+UT_ARGS ?= '--gtest_filter=-Benchmark.*' # ベンチマークは時間がかかり最適化なしでは無意味なため、bench-utでのみ実行する
+
 $(EXE_DONE) : $(EXE) # 単体テストが成功すれば$(EXE_DONE)を作る
-	$(COVERAGE_ENV) ./$< && touch $@
+	$(COVERAGE_ENV) $(UT_ENV) ./$< $(UT_ARGS) && touch $@
 
 ifdef SRCS
 ut:
@@ -99,7 +104,7 @@ cov: $(O)cov.lcov
 	genhtml $(O)cov.lcov -o $(O)coverage
 	@rm -rf $(O)cov.lcov $(O)cov1.lcov $(O)cov2.lcov
 
-CLEAN_DIRS:=d/ g++/ clang++/ sanitizer/ scan-build/
+CLEAN_DIRS:=d/ g++/ clang++/ sanitizer/ scan-build/ bench/
 CLEAN_DIRS:=$(addprefix $(OBJDIR), $(CLEAN_DIRS))
 
 .PHONY : clean clean_gtest
@@ -129,6 +134,25 @@ san:
 	$(MAKE) O=$(OBJDIR)sanitizer/ ut
 fource_san-ut: ;
 
+# ベンチマークは最適化ビルドで計測しなければ意味がない
+# 未定義動作を示すサンプルは-O2で警告されるため、-Werrorは外す
+BENCH_OPTIMIZE:=-O2
+BENCH_RESULT:=$(OBJDIR)bench/benchmark
+BENCH_BASELINE ?= benchmark_baseline.csv
+BENCH_ENV:=BENCHMARK_CSV=$(BENCH_RESULT).csv BENCHMARK_JSON=$(BENCH_RESULT).json \
+	$(if $(wildcard $(BENCH_BASELINE)),BENCHMARK_BASELINE=$(BENCH_BASELINE))
+
+.PHONY : bench bench-ut bench-baseline
+bench:
+	$(MAKE) OPTIMIZE=$(BENCH_OPTIMIZE) COVERAGE= WARN_ERROR= O=$(OBJDIR)bench/
+
+bench-ut: # $(BENCH_BASELINE)が存在すれば、それと比較して遅くなったベンチマークがあれば失敗する
+	rm -f $(OBJDIR)bench/$(EXE_NODIR).done
+	$(MAKE) OPTIMIZE=$(BENCH_OPTIMIZE) COVERAGE= WARN_ERROR= O=$(OBJDIR)bench/ UT_ENV="$(BENCH_ENV)" UT_ARGS= ut
+
+bench-baseline: bench-ut # 今回の計測結果を以後のbench-utのベースラインにする
+	cp $(BENCH_RESULT).csv $(BENCH_BASELINE)
+
 .PHONY : clang clang-ut
 clang:
 	$(MAKE) CXX=clang++
@@ -160,6 +184,10 @@ complete :
 	@echo "  clang-cov    : generate line coverage of clang ut."
 	@echo "  san          : generate all *.o by g++sanitizer."
 	@echo "  san-ut       : execute ut using sanitizer binary."
+	@echo "  bench        : generate all *.o by optimized(-O2) build."
+	@echo "  bench-ut     : execute ut(and benchmarks) using optimized binary."
+	@echo "                 compare with $(BENCH_BASELINE) if it exists."
+	@echo "  bench-baseline : save the result of bench-ut to $(BENCH_BASELINE)."
 	@echo "  scan-build   : static code analysis by scan-build."
 	@echo "  clean        : call xxx_clean."
 	@echo "  doxy         : generate doxygen docs."